@@ -11,9 +11,14 @@
 
 #include "compiler.h"
 
-const unsigned int g_initial_s5_stack[3]={
+/*
+	-12($s5) must be writable, because GOSUB without arguments stack
+	(see optimize_gosub() in linker.c) stores $sp here.
+*/
+unsigned int g_initial_s5_stack[4]={
+	0,                                     // -12($s5): $sp
 	0,                                     // -8($s5): no object
-	(unsigned int) &g_initial_s5_stack[2], // -4($s5): previous $s5 (recursive)
+	(unsigned int) &g_initial_s5_stack[3], // -4($s5): previous $s5 (recursive)
 	0                                      //  0($s5): no parameter
 };
 
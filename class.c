@@ -25,13 +25,15 @@ static int* g_class_structure;
 /*
 	CMPDATA_FIELD structure
 		type:      CMPDATA_FIELD (3)
-		len:       2 or 3 (2: field; 3: method)
+		len:       4 or 3 (4: field; 3: method)
 		data16:    field or method
 		             CMPTYPE_PUBLIC_FIELD:  0
 		             CMPTYPE_PRIVATE_FIELD: 1
 		             CMPTYPE_PUBLIC_METHOD: 2
 		record[1]: field/method name as integer
-		record[2]: pointer to method
+		record[2]: var number of field, or pointer to method
+		record[3]: number of references to field (bit 0-15) and 
+		           number of direct accesses in them (bit 16-31)
 */
 /*
 	CMPDATA_FASTFIELD structure
@@ -67,6 +69,12 @@ static int* g_class_structure;
 		record[2]: method name as integer
 		record[3]: address of code for pointer to method
 
+		type:      CMPDATA_UNSOLVED (5)
+		len:       3
+		data16:    CMPTYPE_STATIC_OBJECT (2)
+		record[1]: class name as integer
+		record[2]: address of code for pointer to static object
+
 */
 
 /*
@@ -85,12 +93,36 @@ static int* g_class_structure;
 
 		This logic is useless for public method, because library must be always called
 		before calling public method.
+
+		When the object variable is declared with class by "USEVAR xxx AS yyy" statement,
+		the address of field and method is also defined when compiling. In this case,
+		the class of object is checked only in debug mode.
+
+		When fast field access cannot be used, an inline cache is embedded in the code
+		(see _obj_field()). It contains the field name, the pointer to class structure,
+		and the position of field. lib_obj_field() searches the field only when the class
+		of object differs from the cached one, and updates the cache.
+*/
+
+/*
+	About direct field access
+		In class file, a field is used as a long name variable. Instead of copying
+		all the fields to the variables when calling a method (and copying back after
+		the method), integer and float fields are read/written directly in the object,
+		of which pointer is -8($s5) (see prepare_args_stack()). As the position of field
+		in object is determined at the end of class file, following codes are used first
+		(see field_or_var_code()) and resolved before linking (see resolve_field_codes()):
+			lw          v1,-8(s5)
+			lw/sw       v0,xx(v1)     (xx: var number * 4)
+		If the field is used in any other way (for example, DIM, FOR, or string), all the
+		codes of the field are changed to access the variable, and the field is copied
+		as before.
 */
 
 /*
 	Local prototyping
 */
-char* obj_method(int method);
+char* obj_method(int method, int* classdata);
 
 /*
 	Return code used for calling null method
@@ -181,6 +213,14 @@ char* resolve_unresolved(int class){
 				code[0]=(code[0]&0xFC000000)|((i&0x0FFFFFFF)>>2);
 				// All done
 				break;
+			case CMPTYPE_STATIC_OBJECT:
+				// Resolve address of code for pointer to static object
+				i=(int)static_object(classdata);
+				code=(int*)(record[2]);
+				code[0]=(code[0]&0xFFFF0000) | (((unsigned int)i)>>16);
+				code[1]=(code[1]&0xFFFF0000) | (((unsigned int)i) & 0x0000FFFF);
+				// All done
+				break;
 			default:
 				return ERR_UNKNOWN;
 		}
@@ -212,13 +252,14 @@ char* update_class_info(int class){
 		                bit 0-7:   # of public fields
 		                bit 8-15:  # of private fields
 		                bit 16-23: # of public methods
-		                bit 24-31: reserved
+		                bit 24-31: 1 if any field is copied to/from variable
 		cstruct[x]:   public field name
-		cstruct[x+1]: public field var number
+		cstruct[x+1]: public field var number (bit 31: direct field access)
 		cstruct[y]:   private field name
-		cstruct[y+1]: private field var number
+		cstruct[y+1]: private field var number (bit 31: direct field access)
 		cstruct[z]:   public method name
 		cstruct[z+1]: public method pointer
+		cstruct[w]:   static object (see static_object())
 */
 
 /*
@@ -279,7 +320,19 @@ char* construct_class_structure(int class){
 		if ((
 			g_class_structure[i*2+1]=search_var_name(0x7FFFFFFF & g_class_structure[i*2])+ALLOC_LNV_BLOCK
 			)<ALLOC_LNV_BLOCK) return ERR_UNKNOWN;
+		// Direct field access or not (see resolve_field_codes())
+		record=search_field_record(g_class_structure[i*2+1]);
+		if (record && field_is_direct(record)) {
+			g_class_structure[i*2+1]|=0x80000000;
+		} else {
+			g_class_structure[1]|=1<<24;
+		}
 	}
+	// Static object, following the class structure
+	num=object_size(g_class_structure);
+	check_obj_space(num);
+	g_object[g_objpos++]=(int)g_class_structure;
+	for(i=1;i<num;i++) g_object[g_objpos++]=0;
 	return 0;
 }
 
@@ -340,6 +393,18 @@ int object_size(int* classdata){
 	return size+1;	
 }
 
+int* static_object(int* classdata){
+	// A zero-filled object placed after the class structure.
+	// This is used as the current object when a method is called as static method
+	// from outside of class, so direct field accesses in the method are valid.
+	int nums=classdata[1];
+	classdata+=2;
+	classdata+=2*(nums&0xff);
+	classdata+=2*((nums>>8)&0xff);
+	classdata+=2*((nums>>16)&0xff);
+	return classdata;
+}
+
 char* new_function(){
 	char* err;
 	int class,size;
@@ -372,14 +437,13 @@ char* new_function(){
 		size=0;
 	}
 	// Create object
+	// First word of object is pointer to classdata (see lib_calloc_memory())
+	check_obj_space(2);
+	record[1]=(int)&g_object[g_objpos];
+	g_object[g_objpos++]=0x3C050000|(((unsigned int)classdata)>>16);        // lui         a1,xxxx
+	g_object[g_objpos++]=0x34A50000|(((unsigned int)classdata)&0x0000FFFF); // ori         a1,a1,xxxx
 	record[2]=(int)&g_object[g_objpos+3];
 	call_quicklib_code(lib_calloc_memory,ASM_ORI_A0_ZERO_|size);
-	// First word of object is pointer to classdata
-	check_obj_space(3);
-	record[1]=(int)&g_object[g_objpos];
-	g_object[g_objpos++]=0x3C080000|(((unsigned int)classdata)>>16);        // lui         t0,xxxx
-	g_object[g_objpos++]=0x35080000|(((unsigned int)classdata)&0x0000FFFF); // ori         t0,t0,xxxx
-	g_object[g_objpos++]=0xAC480000; // sw          t0,0(v0)
 	// Check if INIT method exists
 	if (classdata) {
 		init_method=search_method(classdata,LABEL_INIT);
@@ -403,7 +467,7 @@ char* new_function(){
 	check_obj_space(2);
 	g_object[g_objpos++]=0x27BDFFFC; // addiu       sp,sp,-4
 	g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
-	err=obj_method(LABEL_INIT);
+	err=obj_method(LABEL_INIT,classdata);
 	if (err) return err;
 	g_srcpos--; // Leave ')' character for detecting end of "new" function
 	check_obj_space(2);
@@ -417,7 +481,7 @@ char* new_function(){
 char* field_statement(){
 	char* err;
 	int i;
-	int data[1];
+	int data[3];
 	int is_private=0;
 	// This statement is valid only in class file.
 	if (!g_compiling_class) return ERR_INVALID_NON_CLASS;
@@ -435,6 +499,8 @@ char* field_statement(){
 		// Register varname
 		err=register_var_name(i);
 		if (err) return err;
+		data[1]=search_var_name(i)+ALLOC_LNV_BLOCK;
+		data[2]=0;
 		if (g_source[g_srcpos]=='#') {
 			g_srcpos++;
 		} else if (g_source[g_srcpos]=='$') {
@@ -450,9 +516,9 @@ char* field_statement(){
 		// Register field
 		data[0]=i;
 		if (is_private) {
-			err=cmpdata_insert(CMPDATA_FIELD,CMPTYPE_PRIVATE_FIELD,(int*)&data[0],1);
+			err=cmpdata_insert(CMPDATA_FIELD,CMPTYPE_PRIVATE_FIELD,(int*)&data[0],3);
 		} else {
-			err=cmpdata_insert(CMPDATA_FIELD,CMPTYPE_PUBLIC_FIELD,(int*)&data[0],1);
+			err=cmpdata_insert(CMPDATA_FIELD,CMPTYPE_PUBLIC_FIELD,(int*)&data[0],3);
 		}
 		next_position();
 		if (g_source[g_srcpos]==',') {
@@ -465,14 +531,113 @@ char* field_statement(){
 }
 
 /*
-	char* obj_method(int method);
+	Direct field access
+*/
+
+int* search_field_record(int var_num){
+	int* record;
+	cmpdata_reset();
+	while(record=cmpdata_find(CMPDATA_FIELD)){
+		if ((record[0]&0xffff)==CMPTYPE_PUBLIC_METHOD) continue;
+		if (record[2]==var_num) return record;
+	}
+	return 0;
+}
+
+void count_field_reference(int var_num, int num){
+	// This is called from get_var_number() (num=1), and when the variable is not
+	// used after calling get_var_number() (num=-1).
+	int* record;
+	if (!g_compiling_class) return;
+	record=search_field_record(var_num);
+	if (record) record[3]+=num;
+}
+
+int field_is_direct(int* record){
+	// String and dimension fields are always copied.
+	if (record[1]&0x80000000) return 0;
+	// All the references must be direct accesses.
+	return (record[3]&0xffff)==((record[3]>>16)&0xffff);
+}
+
+char* field_or_var_code(int var_num, int code){
+	// code is "lw xx,0(s8)" or "sw xx,0(s8)"
+	int* record;
+	if (g_compiling_class) record=search_field_record(var_num);
+	else record=0;
+	if (record && !(record[1]&0x80000000)) {
+		// Field of object
+		record[3]+=0x10000;
+		check_obj_space(2);
+		g_object[g_objpos++]=0x8EA30000|ARGS_S5_V0_OBJ;               // lw          v1,-8(s5)
+		g_object[g_objpos++]=(code&0xFC1F0000)|0x00600000|(var_num*4); // lw/sw       xx,xx(v1)
+	} else {
+		check_obj_space(1);
+		g_object[g_objpos++]=code|(var_num*4);                         // lw/sw       xx,xx(s8)
+	}
+	return 0;
+}
+
+int field_position(int var_num){
+	// Returns the position of field in object (see construct_class_structure())
+	int* record;
+	int pos=0;
+	cmpdata_reset();
+	while(record=cmpdata_find(CMPDATA_FIELD)){
+		if ((record[0]&0xffff)!=CMPTYPE_PUBLIC_FIELD) continue;
+		pos++;
+		if (record[2]==var_num) return pos;
+	}
+	cmpdata_reset();
+	while(record=cmpdata_find(CMPDATA_FIELD)){
+		if ((record[0]&0xffff)!=CMPTYPE_PRIVATE_FIELD) continue;
+		pos++;
+		if (record[2]==var_num) return pos;
+	}
+	return 0;
+}
+
+void resolve_field_codes(void){
+	int pos,code,var_num;
+	int* record;
+	for(pos=0;pos<g_objpos-1;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			// Skip data block
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		if (code!=(0x8EA30000|ARGS_S5_V0_OBJ)) continue;         // lw          v1,-8(s5)
+		code=g_object[pos+1];
+		if ((code&0xFFE00000)!=0x8C600000 && (code&0xFFE00000)!=0xAC600000) continue;
+		var_num=(code&0xFFFF)>>2;
+		record=search_field_record(var_num);
+		if (!record) continue;
+		if (field_is_direct(record)) {
+			// Access the field in object
+			g_object[pos+1]=(code&0xFFFF0000)|(field_position(var_num)*4); // lw/sw       xx,xx(v1)
+		} else {
+			// Access the variable
+			g_object[pos]=(code&0xFC1F0000)|0x03C00000|(var_num*4);        // lw/sw       xx,xx(s8)
+			g_object[pos+1]=0x00000000;                                     // nop
+		}
+		pos++;
+	}
+}
+
+/*
+	char* obj_method(int method, int* classdata);
 	Implementation of access to method of object.
+	An inline cache for the method is embedded in the code (see lib_pre_method()).
+	When the class of object is known when compiling, classdata is the pointer to
+	class structure, and the cache is filled here. Otherwise, classdata is 0.
 */
-char* obj_method(int method){
+char* obj_method(int method, int* classdata){
 	// $v0 contains the address of object.
 	// Note that '(' has been passed.
 	char* err;
 	int stack,opos;
+	int address;
 	// When method of an object is called from object, 
 	// current variables must be saved to object fields
 	if (g_compiling_class) {
@@ -489,10 +654,17 @@ char* obj_method(int method){
 	if (g_source[g_srcpos]!=')') return ERR_SYNTAX;
 	g_srcpos++;
 	// Determine address of method and store fields to local variables.
-	check_obj_space(3);
+	if (classdata) address=(int)search_method(classdata,method);
+	else address=0;
+	if (!address) classdata=0;
+	check_obj_space(6);
 	g_object[g_objpos++]=0x8FA20000|ARGS_SP_V0_OBJ;            // lw          v0,8(sp)
-	g_object[g_objpos++]=0x3C050000|((method>>16)&0x0000FFFF); // lui   a1,xxxx
-	g_object[g_objpos++]=0x34A50000|(method&0x0000FFFF);       // ori a1,a1,xxxx
+	g_object[g_objpos++]=0x04110004;                           // bgezal zero,label0
+	g_object[g_objpos++]=0x03E02821;                           // addu   a1,ra,zero
+	g_object[g_objpos++]=method;                               // method name
+	g_object[g_objpos++]=(int)classdata;                       // pointer to class structure
+	g_object[g_objpos++]=address;                              // address of method
+	                                                           // label0:
 	call_quicklib_code(lib_pre_method,ASM_ADDU_A0_V0_ZERO);
 	// Call method address here. Same routine for GOSUB statement with integer value is used.
 	check_obj_space(6);
@@ -538,23 +710,36 @@ char* obj_method(int method){
 
 char* _obj_field(char mode){
 	// $v0 contains the address of object.
-	int i;
+	int i,j;
 	char* err;
 	int* record;
-	char fastfield;
+	int* classdata;
+	int fastfield;
+	// Class structure of object if known (see USEVAR xxx AS yyy)
+	classdata=g_obj_class;
+	g_obj_class=0;
+#ifdef __DEBUG
+	if (classdata) {
+		// Check the class of object when debugging
+		check_obj_space(2);
+		g_object[g_objpos++]=0x3C050000|(((unsigned int)classdata)>>16);        // lui   a1,xxxx
+		g_object[g_objpos++]=0x34A50000|(((unsigned int)classdata)&0x0000FFFF); // ori a1,a1,xxxx
+		call_quicklib_code(lib_check_class,ASM_ADDU_A0_V0_ZERO);
+	}
+#endif
 	do {
 		i=check_var_name();
 		if (i<65536) return ERR_SYNTAX;
 		if (g_source[g_srcpos]=='(' && mode==OBJ_FIELD_INTEGER) {
 			// This is a method
 			g_srcpos++;
-			return obj_method(i);
+			return obj_method(i,classdata);
 		} else if (g_source[g_srcpos+1]=='(') {
 			if (g_source[g_srcpos]==mode) {
 				// This is a string/float method
 				g_srcpos++;
 				g_srcpos++;
-				return obj_method(i);
+				return obj_method(i,classdata);
 			}
 		} else if (g_source[g_srcpos]==mode && mode==OBJ_FIELD_STRING) {
 			// This is a string field. Raise 31st bit.
@@ -565,7 +750,16 @@ char* _obj_field(char mode){
 		while(record=cmpdata_find(CMPDATA_FASTFIELD)){
 			if (record[1]==(i&0x7FFFFFFF)) break;
 		}
-		if (!record) {
+		if (classdata) {
+			// Class is known. Search public field.
+			for(j=0;j<(classdata[1]&0xff);j++){
+				if (classdata[2+j*2]==i) break;
+			}
+			if (j==(classdata[1]&0xff)) return ERR_NOT_FIELD;
+			fastfield=j+1;
+			// The class of next object is unknown
+			classdata=0;
+		} else if (!record) {
 			// Record wasn't found
 			fastfield=0;
 		} else if (1!=g_num_classes && !g_option_fastfield) {
@@ -576,20 +770,25 @@ char* _obj_field(char mode){
 			fastfield=0;
 		} else {
 			// All requirements passed
-			fastfield=1;
+			fastfield=record[0]&0xffff;
 		}
 		// Generate code here
 		if (fastfield) {
 			// Get field value in $v0 and address in $v1
-			i=(record[0]&0xffff)*4;
+			i=fastfield*4;
 			check_obj_space(2);
 			g_object[g_objpos++]=0x24430000|i; // addiu v1,v0,xxxx
 			g_object[g_objpos++]=0x8C620000;   // lw v0,0(v1)
 		} else {
-			check_obj_space(2);
-			g_object[g_objpos++]=0x3C050000|((i>>16)&0x0000FFFF); // lui   a1,xxxx
-			g_object[g_objpos++]=0x34A50000|(i&0x0000FFFF);       // ori a1,a1,xxxx
-			// First and second arguments are address of object and field name, respectively.
+			// Inline cache (see lib_obj_field())
+			check_obj_space(5);
+			g_object[g_objpos++]=0x04110004; // bgezal zero,label1
+			g_object[g_objpos++]=0x03E02821; // addu   a1,ra,zero
+			g_object[g_objpos++]=i;          // field name
+			g_object[g_objpos++]=0;          // pointer to class structure
+			g_object[g_objpos++]=0;          // position of field
+			                                 // label1:
+			// First and second arguments are address of object and inline cache, respectively.
 			call_quicklib_code(lib_obj_field,ASM_ADDU_A0_V0_ZERO);
 		}
 		// Check if "." follows
@@ -619,24 +818,56 @@ char* float_obj_field(){
 	return _obj_field(OBJ_FIELD_FLOAT);
 }
 
-int lib_obj_field(int* object, int fieldname){
+int* var_class_structure(int var_num){
+	// Returns the pointer to class structure of object variable
+	// declared by "USEVAR xxx AS yyy" statement, or 0 if unknown.
+	int* record;
+	int class;
+	class=search_var_class(var_num);
+	if (!class) return 0;
+	cmpdata_reset();
+	while(record=cmpdata_find(CMPDATA_CLASS)){
+		if (record[1]==class) return (int*)record[2];
+	}
+	return 0;
+}
+
+int lib_check_class(int* object, int* class){
+	// Check if this is an object of the class
+	if (!withinRAM(object)) err_not_obj();
+	if (object[0]!=(int)class) err_not_obj();
+	return (int)object;
+}
+
+int lib_obj_field(int* object, int* cache){
+	// cache[0]: field name
+	// cache[1]: pointer to class structure
+	// cache[2]: position of field in object
 	int* class;
 	int i,numfield;
 	// Check if this is an object (if within the RAM).
 	if (!withinRAM(object)) err_not_obj();
 	class=(int*)object[0];
-	if (!withinRAM(class)) err_not_obj();
-	// Obtain # of public field
-	numfield=class[1]&0xff;
-	for(i=0;i<numfield;i++){
-		if (class[2+i*2]==fieldname) break;
+	// Note that the empty cache has 0 as class, which must not be hit.
+	if (!class || class!=(int*)cache[1]) {
+		// Cache miss
+		if (!withinRAM(class)) err_not_obj();
+		// Obtain # of public field
+		numfield=class[1]&0xff;
+		for(i=0;i<numfield;i++){
+			if (class[2+i*2]==cache[0]) break;
+		}
+		if (i==numfield) err_not_field(cache[0],class[0]);
+		// Update cache
+		cache[1]=(int)class;
+		cache[2]=1+i;
 	}
-	if (i==numfield) err_not_field(fieldname,class[0]);
+	i=cache[2];
 	// Got address of field. Return value as $v0 and address as $v1.
-	g_temp=(int)(&object[1+i]);
+	g_temp=(int)(&object[i]);
 	asm volatile("la $v1,%0"::"i"(&g_temp));
 	asm volatile("lw $v1,0($v1)");
-	return object[1+i];
+	return object[i];
 }
 
 /*
@@ -644,9 +875,9 @@ int lib_obj_field(int* object, int fieldname){
 */
 
 void lib_let_str_field(char* prev_str, char* new_str){
-	int var_num=get_permanent_var_num();
+	if (prev_str==new_str) return;
 	free_perm_str(prev_str);
-	lib_let_str(new_str,var_num);
+	let_perm_str(new_str);
 	return;
 }
 
@@ -655,24 +886,24 @@ void lib_let_str_field(char* prev_str, char* new_str){
 */
 
 int lib_load_vars_from_fields(int* object, int v0){
-	// Do nothing if no object
-	if (object) lib_pre_method(object,LABEL_INIT);
-	return v0;
-}
-
-int lib_pre_method(int* object, int methodname){
 	int i,num,nums;
 	int* class;
+	// Do nothing if no object
+	if (!object) return v0;
 	// Check if this is an object (if within the RAM).
 	if (!withinRAM(object)) err_not_obj();
 	class=(int*)object[0];
 	if (!withinRAM(class)) err_not_obj();
 	// Save object field values in local variables in class
 	nums=class[1];
+	// Do nothing if all fields are accessed directly in object
+	if (!(nums&0xff000000)) return v0;
 	num=nums&0xff;
 	for(i=0;i<num;i++){
 		// Public fields
 		class+=2;
+		// Skip if accessed directly in object
+		if (0x80000000&class[1]) continue;
 		g_var_mem[class[1]]=object[i+1];
 		// When string, move from permanent block
 		if (0x80000000&class[0]) move_from_perm_block_if_exists(class[1]);
@@ -681,29 +912,44 @@ int lib_pre_method(int* object, int methodname){
 	for(i=i;i<num;i++){
 		// Private fields
 		class+=2;
+		// Skip if accessed directly in object
+		if (0x80000000&class[1]) continue;
 		g_var_mem[class[1]]=object[i+1];
 		// When string/dimension, move from permanent block
 		if (0x80000000&class[0]) move_from_perm_block_if_exists(class[1]);
 	}
-	// Seek method
-	num+=(nums>>16)&0xff;
-	for(i=i;i<num;i++){
-		class+=2;
-		if (class[0]==methodname) break;
-	}
-	if (i==num) {
-		// Method not found
-		if (methodname==LABEL_INIT) {
+	return v0;
+}
+
+int lib_pre_method(int* object, int* cache){
+	// cache[0]: method name
+	// cache[1]: pointer to class structure
+	// cache[2]: address of method
+	int i;
+	int* class;
+	// Check if this is an object (if within the RAM).
+	if (!withinRAM(object)) err_not_obj();
+	class=(int*)object[0];
+	// Note that the empty cache has 0 as class, which must not be hit.
+	if (!class || class!=(int*)cache[1]) {
+		// Cache miss. Seek method.
+		if (!withinRAM(class)) err_not_obj();
+		i=(int)search_method(class,cache[0]);
+		if (!i) {
+			// Method not found
+			if (cache[0]!=LABEL_INIT) err_not_field(cache[0],class[0]);
 			// INIT method not found
 			// Call null function
-			return (int)(&g_return_code[0]);
-		} else {
-			class=(int*)object[0];
-			err_not_field(methodname,class[0]);
+			i=(int)(&g_return_code[0]);
 		}
+		// Update cache
+		cache[1]=(int)class;
+		cache[2]=i;
 	}
-	// Method found. return it.
-	return class[1];
+	// Save object field values in local variables in class
+	lib_load_vars_from_fields(object,0);
+	// Return address of method
+	return cache[2];
 }
 
 int lib_save_vars_to_fields(int* object,int v0){
@@ -726,10 +972,14 @@ int lib_post_method(int* object, int v0){
 	// Restore local variables to object field values
 	class=(int*)object[0];
 	nums=class[1];
+	// Do nothing if all fields are accessed directly in object
+	if (!(nums&0xff000000)) return v0;
 	num=nums&0xff;
 	for(i=0;i<num;i++){
 		// Public fields
 		class+=2;
+		// Skip if accessed directly in object
+		if (0x80000000&class[1]) continue;
 		object[i+1]=g_var_mem[class[1]];
 		// When string, move to permanent block
 		if (0x80000000&class[0]) {
@@ -740,6 +990,8 @@ int lib_post_method(int* object, int v0){
 	for(i=i;i<num;i++){
 		// Private fields
 		class+=2;
+		// Skip if accessed directly in object
+		if (0x80000000&class[1]) continue;
 		object[i+1]=g_var_mem[class[1]];
 		// When string/dimension, move to permanent block
 		if (0x80000000&class[0]) {
@@ -876,6 +1128,7 @@ char* static_method(char type){
 	char* err;
 	int* data;
 	int record[3];
+	int objrecord[2];
 	int i,opos,method,stack;
 	next_position();
 	// Check class name
@@ -917,8 +1170,23 @@ char* static_method(char type){
 	if (g_source[g_srcpos]!='(') return ERR_SYNTAX;
 	g_srcpos++;
 	// Begin parameter(s) construction routine
-	check_obj_space(1);
-	g_object[g_objpos++]=0x34020000; // ori v0,zero,0
+	check_obj_space(2);
+	if (record[0]==g_compiling_class) {
+		// Static method of the same class. Fields of current object are accessible.
+		g_object[g_objpos++]=0x8EA20000|ARGS_S5_V0_OBJ; // lw v0,-8(s5)
+	} else {
+		// Static method called from outside of class. Use static object of the class.
+		objrecord[0]=record[0];
+		objrecord[1]=(int)&g_object[g_objpos];
+		if (data) i=(int)static_object(data);
+		else i=0;
+		g_object[g_objpos++]=0x3C020000|(((unsigned int)i)>>16);        // lui         v0,xxxx
+		g_object[g_objpos++]=0x34420000|(((unsigned int)i)&0x0000FFFF); // ori         v0,v0,xxxx
+		if (!data) {
+			cmpdata_insert(CMPDATA_UNSOLVED,CMPTYPE_STATIC_OBJECT,(int*)&objrecord[0],2);
+			g_allow_shift_obj=0;
+		}
+	}
 	err=prepare_args_stack('(');
 	if (err) return err;
 	// Calling subroutine, which is static method of class
@@ -952,15 +1220,18 @@ char* let_object_field(){
 	char* err;
 	char b3;
 	int spos,opos;
+	int* classdata;
 	// $v0 contains the pointer to object
 	spos=g_srcpos;
 	opos=g_objpos;
+	classdata=g_obj_class;
 	// Try string field, first
 	err=string_obj_field();
 	if (err) {
 		// Integer or float field
 		g_srcpos=spos;
 		g_objpos=opos;
+		g_obj_class=classdata;
 		err=integer_obj_field();
 		if (err) return err;
 		b3=g_source[g_srcpos];
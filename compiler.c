@@ -18,7 +18,7 @@
 	$a0-$a2: parameters for calling library ($a2=$v0)
 	$a3:     function # for library
 	$t0-$t7: used as temporary registors
-	$s0-$s4: not used
+	$s0-$s4: base addresses of arrays in loop (see hoist_loop_invariants())
 	$s5:     pointer to parameters list
 	$s6:     line or label number
 	$s7:     address of call_library()
@@ -60,7 +60,7 @@ void start_program(void* addr, void* memory){
 	asm volatile("la $v1,label");
 	asm volatile("sw $v1,0($v0)");
 	// Set s5 for initial_s5_stack
-	asm volatile("la $s5,%0"::"i"(&g_initial_s5_stack[2]));
+	asm volatile("la $s5,%0"::"i"(&g_initial_s5_stack[3]));
 	// Set s7 for easy calling call_library()
 	asm volatile("la $s7,%0"::"i"(&call_library));
 	// Set fp and execute program
@@ -83,19 +83,108 @@ int get_fp(void){
 }
 
 
-void shift_obj(int* src, int* dst, int len){
-	int i;
-	if (dst<src) {
-		for(i=0;i<len;i++){
-			dst[i]=src[i];
+/*
+	Block memory operations
+	These are used by MEMCPY/MEMSET/MEMCMP and by the system.
+	When two addresses have the same alignment, 32 bit load/store is used.
+*/
+
+void mem_copy(void* dst, void* src, int len){
+	// Overlapped regions can be used.
+	unsigned char* d=(unsigned char*)dst;
+	unsigned char* s=(unsigned char*)src;
+	int* dw;
+	int* sw;
+	if (len<=0 || d==s) return;
+	if (d<s || s+len<=d) {
+		// Forward
+#if DMA_MEMCPY_MIN
+		if (DMA_MEMCPY_MIN<=len && (s+len<=d || d+len<=s) && dma_memcpy(d,s,len)) return;
+#endif
+		if (!(((int)d^(int)s)&3)) {
+			for(;len && ((int)d&3);len--) *d++=*s++;
+			dw=(int*)d;
+			sw=(int*)s;
+			for(;16<=len;len-=16){
+				dw[0]=sw[0];
+				dw[1]=sw[1];
+				dw[2]=sw[2];
+				dw[3]=sw[3];
+				dw+=4;
+				sw+=4;
+			}
+			for(;4<=len;len-=4) *dw++=*sw++;
+			d=(unsigned char*)dw;
+			s=(unsigned char*)sw;
 		}
-	} else if (src<dst) {
-		for(i=len-1;0<=i;i--){
-			dst[i]=src[i];
+		while(len--) *d++=*s++;
+	} else {
+		// Backward
+		d+=len;
+		s+=len;
+		if (!(((int)d^(int)s)&3)) {
+			for(;len && ((int)d&3);len--) *--d=*--s;
+			dw=(int*)d;
+			sw=(int*)s;
+			for(;16<=len;len-=16){
+				dw-=4;
+				sw-=4;
+				dw[3]=sw[3];
+				dw[2]=sw[2];
+				dw[1]=sw[1];
+				dw[0]=sw[0];
+			}
+			for(;4<=len;len-=4) *--dw=*--sw;
+			d=(unsigned char*)dw;
+			s=(unsigned char*)sw;
 		}
+		while(len--) *--d=*--s;
 	}
 }
 
+void mem_set(void* dst, int value, int len){
+	unsigned char* d=(unsigned char*)dst;
+	int* dw;
+	value&=0xff;
+	for(;0<len && ((int)d&3);len--) *d++=value;
+	value|=value<<8;
+	value|=value<<16;
+	dw=(int*)d;
+	for(;16<=len;len-=16){
+		dw[0]=value;
+		dw[1]=value;
+		dw[2]=value;
+		dw[3]=value;
+		dw+=4;
+	}
+	for(;4<=len;len-=4) *dw++=value;
+	d=(unsigned char*)dw;
+	for(;0<len;len--) *d++=value;
+}
+
+int mem_cmp(void* p1, void* p2, int len){
+	// Returns the difference of first different bytes, or 0 if same.
+	unsigned char* s1=(unsigned char*)p1;
+	unsigned char* s2=(unsigned char*)p2;
+	if (!(((int)s1^(int)s2)&3)) {
+		for(;0<len && ((int)s1&3);len--,s1++,s2++){
+			if (*s1!=*s2) return *s1-*s2;
+		}
+		// Skip same words
+		for(;4<=len;len-=4,s1+=4,s2+=4){
+			if (((int*)s1)[0]!=((int*)s2)[0]) break;
+		}
+	}
+	for(;0<len;len--,s1++,s2++){
+		if (*s1!=*s2) return *s1-*s2;
+	}
+	return 0;
+}
+
+void shift_obj(int* src, int* dst, int len){
+	mem_copy(dst,src,len*4);
+}
+
 int strncmp(char* str1, char* str2, int len){
 	int i;
 	for (i=0;i<len;i++) {
@@ -25,10 +25,25 @@
 #define ALLOC_LNV_BLOCK 39
 // Number of long name variables
 #define ALLOC_LNV_NUM 190
-// Start # of permanent blocks
+// Block # for the table of permanent blocks (see memory.c)
 #define ALLOC_PERM_BLOCK 229
 // Number of blocks that can be assigned for memory allocation (including all above)
-#define ALLOC_BLOCK_NUM 329
+#define ALLOC_BLOCK_NUM 230
+
+// Size of buffer for each file handle (bytes; multiple of 4)
+#define FILE_BUFFER_SIZE 512
+// Number of file handles
+#define FILE_HANDLE_NUM 8
+// Number of files that SD library can open at the same time
+#define FILE_SD_SLOTS 2
+// Maximum length of full path of file used for reopening (bytes)
+#define FILE_PATH_SIZE 64
+// Maximum bytes read in each 1/60 sec by FGETASYNC
+#define FILE_ASYNC_SLICE 512
+// Size of each of two buffers used by LOGSTART (bytes; multiple of 4)
+#define LOG_BUFFER_SIZE 2048
+// Number of pages (512 bytes each) cached for each VDIM array
+#define VDIM_PAGES 8
 
 // Persistent RAM bytes used for object, heap and exception data
 #ifndef PERSISTENT_RAM_SIZE
@@ -126,9 +141,71 @@ enum libs{
 	LIB_SETDIRFUNC     =LIB_STEP*52,
 	LIB_GETDIR         =LIB_STEP*53,
 	LIB_READKEY        =LIB_STEP*54,
+	LIB_MAP            =LIB_STEP*55,
+	LIB_SORT           =LIB_STEP*56,
+	LIB_MEMORY         =LIB_STEP*57,
+	LIB_VDIM           =LIB_STEP*58,
+	LIB_KVSTORE        =LIB_STEP*59,
+	LIB_LOGGER         =LIB_STEP*60,
 	LIB_DEBUG          =LIB_STEP*127,
 };
 
+// Flag used with LIB_DIM (see lib_dim())
+#define DIM_FLAT  0x0001
+#define DIM_8BIT  0x0002
+#define DIM_16BIT 0x0004
+#define DIM_DATA  0x0008
+#define DIM_CDATA 0x0010
+
+// Flag in CMPDATA_DIM record for array defined by VDIM (see value.c)
+#define DIM_VDIM_RECORD 0x10000
+// Flags in CMPDATA_DIM record for layout of multi-dimensional array (see dim_layout())
+#define DIM_LAYOUT_RECORD 0x20000
+#define DIM_FLAT_RECORD   0x40000
+
+// Function and flag used with LIB_VDIM (see lib_vdim())
+#define VDIM_NEW       0x0000
+#define VDIM_GET       0x0001
+#define VDIM_SET       0x0002
+#define VDIM_FUNC_MASK 0x0003
+#define VDIM_8BIT      0x0004
+#define VDIM_16BIT     0x0008
+
+// Function used with LIB_KVSTORE (see lib_kvstore())
+#define KV_OPEN 0x0000
+#define KV_PUT  0x0001
+#define KV_GET  0x0002
+
+// Function used with LIB_LOGGER (see lib_logger())
+#define LOG_START 0x0000
+#define LOG_STOP  0x0001
+
+// Function and flag used with LIB_MAP (see lib_map())
+#define MAP_NEW       0x0000
+#define MAP_SET       0x0001
+#define MAP_GET       0x0002
+#define MAP_HAS       0x0003
+#define MAP_DEL       0x0004
+#define MAP_FUNC_MASK 0x000F
+#define MAP_STRKEY    0x0010
+
+// Flag used with LIB_SORT (see lib_sort())
+#define SORT_INT       0x0000
+#define SORT_FLOAT     0x0001
+#define SORT_STR       0x0002
+#define SORT_TYPE_MASK 0x0003
+#define SORT_8BIT      0x0004
+#define SORT_16BIT     0x0008
+#define SORT_DESC      0x0010
+#define SORT_INDEX8    0x0020
+#define SORT_INDEX16   0x0040
+#define SORT_SEARCH    0x0080
+
+// Function used with LIB_MEMORY (see lib_memory())
+#define MEM_COPY 0x0000
+#define MEM_SET  0x0001
+#define MEM_CMP  0x0002
+
 // Note: OP_XXXX and FUNC_XXXX cannot be used simultaneously
 #define FUNC_MASK 0x003F
 #define FUNC_STEP 0x0001
@@ -183,9 +260,16 @@ enum functions{
 	FUNC_FREMOVE     =FUNC_STEP*47,
 	FUNC_FEOF        =FUNC_STEP*48,
 	FUNC_FINIT       =FUNC_STEP*49,
+	FUNC_FGETASYNC   =FUNC_STEP*50,
+	FUNC_FASYNCREMAIN=FUNC_STEP*51,
 	// MAX 63
 };
 
+// Flag used with FUNC_FGET and FUNC_FPUT for array (see lib_file_array())
+#define FILE_ARRAY   0x0040
+#define FILE_ARRAY16 0x0080
+#define FILE_ARRAY32 0x0100
+
 /* Global vars (see globalvers.c) */
 extern int g_intconst;
 extern char g_valueisconst;
@@ -228,12 +312,18 @@ extern int g_class;
 extern int g_compiling_class;
 extern unsigned char g_num_classes;
 extern char g_option_fastfield;
+extern char g_option_flatdim;
+extern int* g_obj_class;
+extern int g_dead_code_size;
 extern int g_temp;
 
 /* Prototypes */
 int get_gp(void);
 int get_fp(void);
 void start_program(void* addr, void* memory);
+void mem_copy(void* dst, void* src, int len);
+void mem_set(void* dst, int value, int len);
+int mem_cmp(void* p1, void* p2, int len);
 void shift_obj(int* src, int* dst, int len);
 char* compile_line(void);
 int nextCodeIs(char* str);
@@ -285,15 +375,21 @@ char* fputc_statement();
 char* fremove_statement();
 char* label_statement();
 char* exec_statement();
+char* get_array_param(int* flags);
+char* mem_statement_main(int func);
 
 char* function(void);
+char* bsearch_function();
+char* memcmp_function();
 char* str_function(void);
 char* float_function(void);
 
 void call_library(void);
 void reset_dataread();
+void release_file_buffers(void);
 void lib_wait(int period);
 
+void set_free_area(void* begin, void* end);
 void free_temp_str(char* str);
 void free_non_temp_str(char* str);
 void free_perm_str(char* str);
@@ -302,14 +398,44 @@ void* calloc_memory(int size, int var_num);
 void move_to_perm_block(int var_num);
 void move_from_perm_block(int var_num);
 int move_from_perm_block_if_exists(int var_num);
-int get_permanent_var_num(void);
+void let_perm_str(char* str);
+void* alloc_perm_memory(int size);
 int get_varnum_from_address(void* address);
-void* lib_calloc_memory(int size);
+int within_heap_block(void* address, int len);
+int object_pool_info(int info, int index);
+void* lib_calloc_memory(int size, int* classdata);
 void lib_delete(int* object);
 
 char* link(void);
 char* get_label(void);
 void* search_label(unsigned int label);
+int get_jump_target(int pos);
+int get_branch_target(int pos);
+int is_return_code(int pos);
+int get_gosub_target(int pos);
+int sub_uses_args(int start);
+int unsolved_in_range(int start, int end);
+int sub_inline_length(int start, int* bstart);
+void optimize_gosub(void);
+char* link_pointers(void);
+int link_work_area(void);
+void relocate_cmpdata(int* (*newaddr)(int* addr));
+int bit_count(unsigned int bits);
+int dce_newpos(int pos);
+int* dce_newaddr(int* addr);
+void dce_keep(int* addr, int num);
+int dce_explore(int pos);
+int dce_mark(void);
+void eliminate_dead_code(void);
+int hoist_newpos(int pos);
+int hoist_newtarget(int pos);
+int* hoist_newaddr(int* addr);
+int hoist_label_refs(unsigned int label);
+unsigned int hoist_marker_label(int pos);
+int hoist_labels_ok(int start, int end);
+int hoist_var_ok(int start, int end, int offset);
+int hoist_loop(int start, int end);
+void hoist_loop_invariants(void);
 
 char* get_string();
 char* simple_string(void);
@@ -321,7 +447,28 @@ char* calculation_float(enum operator op);
 int lib_float(int ia0,int iv0, enum operator a1);
 
 int lib_file(enum functions func, int a0, int a1, int v0);
-
+int file_handle_info(int info, int handle);
+void file_async_interrupt(void);
+void file_async_wait(void);
+int file_async_remaining(void);
+int lib_vdim(int flags, int varnum, int* params, int v0);
+int vdim_info(int info, int* vdim);
+int lib_kvstore(int func, int* params, int v0);
+int logger_sample(void);
+void logger_flush(void);
+int logger_pending(void);
+int logger_active(void);
+int logger_info(int info);
+int lib_logger(int func, int* params, int v0);
+
+int* search_dim_record(int i);
+int get_dim_bits(int i);
+int is_vdim(int i);
+char* dim_layout(int i);
+int dim_sll_code(int bits);
+int dim_load_code(int bits);
+char* flat_dim_mul(int i, int dim);
+char* get_flat_dim_value(int i);
 char* get_dim_value(int i);
 char* get_simple_value(void);
 char* get_value();
@@ -342,6 +489,8 @@ void cmpdata_delete(int* record);
 
 int check_var_name();
 int get_var_number();
+char* register_var_class(int nameint, int class);
+int search_var_class(int var_num);
 int search_var_name(int nameint);
 char* register_var_name(int nameint);
 
@@ -349,20 +498,30 @@ char* update_class_info(int class);
 char* construct_class_structure(int class);
 void delete_cmpdata_for_class(int class);
 
-extern const unsigned int g_initial_s5_stack[3];
+extern unsigned int g_initial_s5_stack[4];
 char* prepare_args_stack(char start_char);
 char* remove_args_stack(void);
 char* args_function_main(void);
 
 char* begin_compiling_class(int class);
 char* end_compiling_class(int class);
+int object_size(int* classdata);
+int* static_object(int* classdata);
 char* new_function();
 char* field_statement();
+int* search_field_record(int var_num);
+void count_field_reference(int var_num, int num);
+int field_is_direct(int* record);
+char* field_or_var_code(int var_num, int code);
+int field_position(int var_num);
+void resolve_field_codes(void);
 char* integer_obj_field();
 char* string_obj_field();
 char* float_obj_field();
-int lib_obj_field(int* object, int fieldname);
-int lib_pre_method(int* object, int methodname);
+int lib_obj_field(int* object, int* cache);
+int* var_class_structure(int var_num);
+int lib_check_class(int* object, int* class);
+int lib_pre_method(int* object, int* cache);
 int lib_post_method(int* object, int v0);
 int lib_save_vars_to_fields(int* object,int v0);
 int lib_load_vars_from_fields(int* object, int v0);
@@ -376,14 +535,38 @@ char* static_statement();
 char* static_method(char type);
 char* resolve_unresolved(int class);
 
+char* mapnew_function();
+char* mapset_statement();
+char* mapget_function();
+char* maphas_function();
+char* mapdel_statement();
+void map_delete(int* map);
+void map_foreach(int* map, void (*func)(int key, int value));
+int lib_map(int flags, int* params, int v0);
+
+void ramdisk_init(void);
+const char* ramdisk_file(const char* name);
+int ramdisk_chdir(const char* path);
+int ramdisk_cwd(void);
+int* ramdisk_fopen(const char* name, const char* mode);
+void ramdisk_fclose(int* rh);
+int ramdisk_fread(char* dest, int len, int* rh);
+int ramdisk_fwrite(char* src, int len, int* rh);
+int ramdisk_fseek(int* rh, int pos);
+int ramdisk_ftell(int* rh);
+int ramdisk_fsize(int* rh);
+int ramdisk_remove(const char* name);
+
 void init_timer();
 void stop_timer();
+void start_timer1(int count);
 char* usetimer_statement();
 char* timer_statement();
 char* timer_function();
 char* coretimer_statement();
 char* coretimer_function();
 char* interrupt_statement();
+void lib_interrupt(int itype);
 
 /* Error messages */
 #define ERR_SYNTAX (char*)(g_err_str[0])
@@ -416,6 +599,9 @@ char* interrupt_statement();
 #define ERR_INVALID_CLASS (char*)(g_err_str[27])
 #define ERR_NO_INIT (char*)(g_err_str[28])
 #define ERR_OPTION_CLASSCODE (char*)(g_err_str[29])
+#define ERR_FLATDIM_SIZE (char*)(g_err_str[30])
+#define ERR_DIM_TYPE (char*)(g_err_str[31])
+#define ERR_FLATDIM_LAYOUT (char*)(g_err_str[32])
 
 /* compile data type numbers */
 #define CMPDATA_RESERVED  0
@@ -426,12 +612,14 @@ char* interrupt_statement();
 #define CMPDATA_UNSOLVED  5
 #define CMPDATA_TEMP      6
 #define CMPDATA_FASTFIELD 7
+#define CMPDATA_DIM       8
 // Sub types follow
 #define CMPTYPE_PUBLIC_FIELD 0
 #define CMPTYPE_PRIVATE_FIELD 1
 #define CMPTYPE_PUBLIC_METHOD 2
 #define CMPTYPE_NEW_FUNCTION 0
 #define CMPTYPE_STATIC_METHOD 1
+#define CMPTYPE_STATIC_OBJECT 2
 
 
 /* Stack position for values in args.c */
@@ -504,6 +692,7 @@ char* interrupt_statement();
 #define INTERRUPT_MUSIC     4
 #define INTERRUPT_WAVE      5
 #define INTERRUPT_CORETIMER 6
+#define INTERRUPT_FILE      7
 
 extern int g_interrupt_flags;
 extern int g_int_vector[];
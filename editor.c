@@ -64,6 +64,12 @@ unsigned char currentfile[13],tempfile[13]; //
 //unsigned char filenames[MAXFILENUM][13]; //[h̃t@Cꗗobt@
 unsigned char (*filenames)[13]; //͔̂zRAM[]̒Ɋmۂ
 
+//t@Cꗗ̃LbVifBNgłSDJ[h̃T[`ȗj
+unsigned char dircachepath[PATHNAMEMAX]; //LbVfBNg̃pX
+int dircachevalid; //LbVLǂ̃tO
+int dircachenum,dircachenumdir; //LbVt@C{fBNgAfBNg
+unsigned int dircachesum; //LbVt@Cꗗ̃`FbNT
+
 //unsigned char undobuf[UNDOBUFSIZE]; //AhDpobt@
 unsigned char *undobuf; //͔̂zRAM[]̒Ɋmۂ
 unsigned char *undobuf_top; //AhDpobt@̐擪w|C^
@@ -98,6 +104,12 @@ void wait60thsec(unsigned short n){
 #endif
 }
 
+void cleardircache(void){
+// t@Cꗗ̃LbVj
+// SDJ[h̃fBNg̓eύXꍇɌĂяo
+	dircachevalid=0;
+}
+
 unsigned int bpixtopos(_tbuf *bp,unsigned int ix){
 // eLXgobt@̈ʒueLXgŜ̐擪牽ڂԂ
 // bp:eLXgobt@|C^
@@ -1332,6 +1344,7 @@ int filesystemretry(){
 			if(vk==VK_ESCAPE) return -1;
 		}
 		//t@CVXe
+		cleardircache(); //J[hꂽꍇɔăLbVj
 		if(FSInit()!=FALSE) return 0; //
 		//G[̏ꍇ
 		setcursorcolor(COLOR_ERRORTEXT);
@@ -1347,6 +1360,7 @@ int sdfilecopy(char *sourcefile,char *distfile){
 	FSFILE *sfp,*dfp;
 	int n,er,c;
 	er=0;
+	cleardircache(); //fBNg̓eς̂ŃLbVj
 	sfp=FSfopen(sourcefile,"r");
 	if(sfp==NULL) return ERR_CANTFILEOPEN;
 	dfp=FSfopen(distfile,"w");
@@ -1381,6 +1395,7 @@ int savetextfile(char *filename){
 	unsigned char *ps,*pd;
 	er=0;//G[R[h
 	i=-1;
+	cleardircache(); //fBNg̓eς̂ŃLbVj
 	fp=FSfopen(filename,"w");
 	if(fp==NULL) return ERR_CANTFILEOPEN;
 	bp=TBufstart;
@@ -1511,6 +1526,42 @@ void printfilename(unsigned char x,unsigned char y,int f,int num_dir){
 		printstr(filenames[f]);
 	}
 }
+void printfilelist(int top,int filenum,int num_dir){
+// 2sڂŉs1s܂ŁAt@Cԍtop̃t@Cꗗ\
+	int f,y;
+	unsigned char *p;
+	for(p=TVRAM+twidth;p<TVRAM+twidth*(twidthy-1);p++) *p=' ';
+	for(f=top;f<filenum;f++){
+		y=(f-top)/2+1;
+		if(y>=twidthy-1) break;
+		printfilename((f&1)*15+1,y,f,num_dir);
+	}
+}
+int scrollfilelist(int f,int top,int filenum,int num_dir){
+// I𒆂̃t@Cԍfʓɓ悤Ɉꗗĕ\AʈԐ擪̃t@CԍԂ
+// top:݂̉ʈԐ擪̃t@Cԍ
+	if(f<top) top=f&0xfffffffe;
+	else if(f-top>=(twidthy-2)*2) top=(f&0xfffffffe)-(twidthy-3)*2;
+	else return top;
+	printfilelist(top,filenum,num_dir);
+	return top;
+}
+int searchfilename(unsigned char *s,int filenum){
+// O̐擪sƈvŏ̃t@C܂̓fBNg̔ԍԂ
+// Ȃꍇ-3Ԃ
+	int f;
+	unsigned char *ps,*pd;
+	for(f=0;f<filenum;f++){
+		ps=filenames[f];
+		pd=s;
+		while(*pd && *ps==*pd){
+			ps++;
+			pd++;
+		}
+		if(*pd==0) return f;
+	}
+	return -3;
+}
 int select_dir_file(int filenum,int num_dir, unsigned char* msg){
 // filenames[]zɓǂݍ܂ꂽt@C܂̓fBNgʕ\L[{[hőI
 // filenum:t@C{fBNg
@@ -1521,11 +1572,15 @@ int select_dir_file(int filenum,int num_dir, unsigned char* msg){
 //@-1FVKfBNg쐬Atempfile[]ɃfBNg
 //@-2FVKt@C쐬Atempfile[]Ƀt@C
 //@-3FESCL[ꂽ
+// L[ƁA͂Ŏn܂閼OđI
 	int top,f;
 	unsigned char *ps,*pd;
-	int x,y;
-	unsigned char vk;
+	int x;
+	unsigned char k,vk;
 	unsigned char vm;
+	unsigned char search[13]; //
+	int searchlen; //̒
+	int searchkey; //ύXL[ꂽǂ̃tO
 
 	//t@Cꗗʂɕ\
 	vm=videomode;
@@ -1536,26 +1591,23 @@ int select_dir_file(int filenum,int num_dir, unsigned char* msg){
 	printstr(": ");
 	setcursorcolor(4);
 	printstr("Select&[Enter] / [ESC]\n");
-	for(f=-2;f<filenum;f++){
-		x=(f&1)*15+1;
-		y=(f+2)/2+1;
-		if(y>=twidthy-1) break;
-		printfilename(x,y,f,num_dir);
-	}
 	top=-2;//ʈԐ擪̃t@Cԍ
 	f=-2;//ݑI𒆂̃t@Cԍ
+	printfilelist(top,filenum,num_dir);
+	searchlen=0;
 	while(1){
 		setcursor((f&1)*15,(f-top)/2+1,5);
 		printchar(0x1c);// Right Arrow
 		cursor--;
 		while(1){
-			inputchar();
+			k=inputchar();
 			vk=vkey & 0xff;
 			if(vk) break;
 		}
 		printchar(' ');
 		setcursor(0,twidthy-1,COLOR_NORMALTEXT);
 		for(x=0;x<twidth-1;x++) printchar(' '); //ŉs̃Xe[^X\
+		searchkey=0;
 		switch(vk){
 			case VK_UP:
 			case VK_NUMPAD8:
@@ -1610,6 +1662,37 @@ int select_dir_file(int filenum,int num_dir, unsigned char* msg){
 				//EL[
 				if((f&1)==0 && f+1<filenum) f++;
 				break;
+			case VK_PRIOR: // PageUpL[
+			case VK_NUMPAD9:
+				//1ʕO
+				f-=(twidthy-2)*2;
+				if(f<-2) f=-2;
+				top=scrollfilelist(f,top,filenum,num_dir);
+				break;
+			case VK_NEXT: // PageDownL[
+			case VK_NUMPAD3:
+				//1ʕ
+				f+=(twidthy-2)*2;
+				if(f>=filenum) f=filenum-1;
+				top=scrollfilelist(f,top,filenum,num_dir);
+				break;
+			case VK_HOME:
+			case VK_NUMPAD7:
+				//ꗗ̐擪
+				f=-2;
+				top=scrollfilelist(f,top,filenum,num_dir);
+				break;
+			case VK_END:
+			case VK_NUMPAD1:
+				//ꗗ̍Ō
+				f=filenum-1;
+				top=scrollfilelist(f,top,filenum,num_dir);
+				break;
+			case VK_BACK: //BackSpaceL[
+				//̍Ō1폜
+				if(searchlen) searchlen--;
+				searchkey=1;
+				break;
 			case VK_RETURN: //EnterL[
 			case VK_SEPARATOR: //eL[Enter
 				if(f==-2){
@@ -1630,6 +1713,7 @@ int select_dir_file(int filenum,int num_dir, unsigned char* msg){
 					//fBNg
 					*tempfile=0;
 					if(lineinput(tempfile,8+1+3)<0) break; //ESCL[
+					cleardircache(); //fBNg̓eς̂ŃLbVj
 					if(FSmkdir(tempfile)){
 						setcursor(0,twidthy-1,COLOR_ERRORTEXT);
 						printstr("Cannot Make Directory        ");
@@ -1649,70 +1733,144 @@ int select_dir_file(int filenum,int num_dir, unsigned char* msg){
 				//ESCL[
 				set_videomode(vm,0);
 				return -3;
+			default:
+				//L[Aɒǉit@C͑啶j
+				if(k<=' ' || k>=0x7f) break;
+				if(k>='a' && k<='z') k-='a'-'A';
+				if(searchlen<12) search[searchlen++]=k;
+				searchkey=1;
+				break;
+		}
+		//L[BackSpaceL[ȊOł͌NA
+		if(searchkey==0) searchlen=0;
+		else if(searchlen){
+			//Čt@CIAŉsɕ\
+			search[searchlen]=0;
+			x=searchfilename(search,filenum);
+			if(x>=0){
+				f=x;
+				top=scrollfilelist(f,top,filenum,num_dir);
+				setcursor(0,twidthy-1,COLOR_NORMALTEXT);
+			}
+			else setcursor(0,twidthy-1,COLOR_ERRORTEXT);
+			printstr("Search: ");
+			printstr(search);
 		}
 	}
 }
+int filetype(unsigned char *s){
+// ꗗɕ\t@C̊gq̏ԂԂ
+// ߂l@1FBASA2FTXTA3FINIA0Fꗗɕ\Ȃt@C
+	while(*s && *s!='.') s++;
+	if(*s==0) return 0;
+	s++;
+	if(s[0]=='B' && s[1]=='A' && s[2]=='S' && s[3]==0) return 1;
+	if(s[0]=='T' && s[1]=='X' && s[2]=='T' && s[3]==0) return 2;
+	if(s[0]=='I' && s[1]=='N' && s[2]=='I' && s[3]==0) return 3;
+	return 0;
+}
+int comparefilename(unsigned char *s1,unsigned char *s2,int isfile){
+// t@C̔riisfile0ȊȌꍇAgq̏ԂD悷j
+// ߂l@s1OȂ畉As2OȂ琳AȂ0
+	int d;
+	if(isfile){
+		d=filetype(s1)-filetype(s2);
+		if(d) return d;
+	}
+	while(*s1 && *s1==*s2){
+		s1++;
+		s2++;
+	}
+	return *s1-*s2;
+}
+void sortfilenames(int start,int n,int isfile){
+// filenames[start]n̖OבւiVF\[gj
+	int gap,i,j,k;
+	unsigned char t[13];
+	for(gap=n/2;gap>0;gap/=2){
+		for(i=start+gap;i<start+n;i++){
+			for(k=0;k<13;k++) t[k]=filenames[i][k];
+			for(j=i;j>=start+gap && comparefilename(filenames[j-gap],t,isfile)>0;j-=gap){
+				for(k=0;k<13;k++) filenames[j][k]=filenames[j-gap][k];
+			}
+			for(k=0;k<13;k++) filenames[j][k]=t[k];
+		}
+	}
+}
+unsigned int calcdircachesum(int filenum){
+// pXƃt@Cꗗ̃`FbNTvZ
+	unsigned int sum;
+	unsigned char *p;
+	int f;
+	sum=filenum;
+	for(p=dircachepath;*p;p++) sum=(sum<<1|sum>>31)+*p;
+	for(f=0;f<filenum;f++){
+		for(p=filenames[f];*p;p++) sum=(sum<<1|sum>>31)+*p;
+	}
+	return sum;
+}
 int getfilelist(int *p_num_dir){
 // JgfBNgł̃fBNgA.BASA.TXTA.INIt@Cꗗǂݍ
 // *p_num_dir:fBNgԂ
-// filenames[]:t@CуfBNgꗗ
+// filenames[]:t@CуfBNgꗗiꂼꖼOj
 // ߂l@t@C{fBNg
+// OƓfBNgŁALbVjĂȂꍇSDJ[hT[`Ȃ
+// LbV̓pXƃt@Cꗗ̃`FbNTŊmF
 
 	unsigned char *ps,*pd;
-	int filenum;
+	unsigned char path[PATHNAMEMAX];
+	int filenum,num_file,f;
 	SearchRec sr;
+	if(FSgetcwd(path,PATHNAMEMAX)==NULL) path[0]=0;
+	if(dircachevalid && path[0]){
+		for(ps=path,pd=dircachepath;*ps && *ps==*pd;ps++,pd++) ;
+		if(*ps==*pd && calcdircachesum(dircachenum)==dircachesum){
+			//LbVgp
+			*p_num_dir=dircachenumdir;
+			return dircachenum;
+		}
+	}
+	dircachevalid=0;
+	//fBNgƃt@CxɃT[`
+	//fBNgfilenames[]̐擪At@C͍Ōォǂݍ
 	filenum=0;
-	//fBNg̃T[`
-	if(FindFirst("*",ATTR_DIRECTORY,&sr)==0){
+	num_file=0;
+	if(FindFirst("*",ATTR_DIRECTORY | ATTR_READ_ONLY | ATTR_HIDDEN | ATTR_SYSTEM | ATTR_ARCHIVE,&sr)==0){
 		do{
-			//filenames[]ɃfBNg̈ꗗǂݍ
+			if(sr.attributes & ATTR_DIRECTORY){
+				//̑fBNg͕\Ȃ
+				if(sr.attributes!=ATTR_DIRECTORY) continue;
+				pd=filenames[filenum++];
+			}
+			else{
+				//gq BASATXTAINIȊÕt@C͕\Ȃ
+				if(filetype(sr.filename)==0) continue;
+				pd=filenames[MAXFILENUM-1-num_file++];
+			}
 			ps=sr.filename;
-			pd=filenames[filenum];
 			while(*ps!=0) *pd++=*ps++;
 			*pd=0;
-			filenum++;
 		}
-		while(!FindNext(&sr) && filenum<MAXFILENUM);
+		while(!FindNext(&sr) && filenum+num_file<MAXFILENUM);
 	}
 	*p_num_dir=filenum;
-	if(filenum>=MAXFILENUM) return filenum;
-	//gq BASt@C̃T[`
-	if(FindFirst("*.BAS",ATTR_READ_ONLY | ATTR_HIDDEN | ATTR_SYSTEM | ATTR_ARCHIVE,&sr)==0){
-		do{
-			//filenames[]Ƀt@C̈ꗗǂݍ
-			ps=sr.filename;
-			pd=filenames[filenum];
-			while(*ps!=0) *pd++=*ps++;
-			*pd=0;
-			filenum++;
-		}
-		while(!FindNext(&sr) && filenum<MAXFILENUM);
-	}
-	if(filenum>=MAXFILENUM) return filenum;
-	//gq TXTt@C̃T[`
-	if(FindFirst("*.TXT",ATTR_READ_ONLY | ATTR_HIDDEN | ATTR_SYSTEM | ATTR_ARCHIVE,&sr)==0){
-		do{
-			//filenames[]Ƀt@C̈ꗗǂݍ
-			ps=sr.filename;
-			pd=filenames[filenum];
-			while(*ps!=0) *pd++=*ps++;
-			*pd=0;
-			filenum++;
-		}
-		while(!FindNext(&sr) && filenum<MAXFILENUM);
-	}
-	if(filenum>=MAXFILENUM) return filenum;
-	//gq INIt@C̃T[`
-	if(FindFirst("*.INI",ATTR_READ_ONLY | ATTR_HIDDEN | ATTR_SYSTEM | ATTR_ARCHIVE,&sr)==0){
-		do{
-			//filenames[]Ƀt@C̈ꗗǂݍ
-			ps=sr.filename;
-			pd=filenames[filenum];
-			while(*ps!=0) *pd++=*ps++;
-			*pd=0;
-			filenum++;
-		}
-		while(!FindNext(&sr) && filenum<MAXFILENUM);
+	//t@CfBNǧɈړ
+	for(f=0;f<num_file;f++){
+		ps=filenames[MAXFILENUM-num_file+f];
+		pd=filenames[filenum+f];
+		while(*ps!=0) *pd++=*ps++;
+		*pd=0;
+	}
+	sortfilenames(0,filenum,0);
+	sortfilenames(filenum,num_file,1);
+	filenum+=num_file;
+	//LbVɓo^
+	if(path[0]){
+		for(ps=path,pd=dircachepath;*pd++=*ps++;) ;
+		dircachenum=filenum;
+		dircachenumdir=*p_num_dir;
+		dircachesum=calcdircachesum(filenum);
+		dircachevalid=1;
 	}
 	return filenum;
 }
@@ -2056,6 +2214,9 @@ void run(int test){
 
 	cls();
 	setcursor(0,0,COLOR_NORMALTEXT);
+	//svOt@C쐬A폜ꍇ̂ŃLbVj
+	//it@Cꗗ̗̈vOsɎgpj
+	cleardircache();
 	while(1){
 		//JgfBNg[gɕύX
 		if(FSchdir((char *)ROOTDIR)){
@@ -2488,6 +2649,7 @@ void texteditor(void){
 	cwdpath=editormalloc(PATHNAMEMAX);
 	filenames=(unsigned char (*)[])editormalloc(MAXFILENUM*13);
 	undobuf=editormalloc(UNDOBUFSIZE);
+	cleardircache(); //t@Cꗗ̃LbV
 
 //	TextBuffer=(_tbuf *)RAM;
 //	clipboard=(unsigned char *)TextBuffer+sizeof(_tbuf)*TBUFMAXLINE;
@@ -18,7 +18,7 @@
 #define COLOR_DIR 6 //fBNg\̐F
 #define COLOR_INV 128 //mN[h̔]
 #define FILEBUFSIZE 256 //t@CANZXpobt@TCY
-#define MAXFILENUM 200 //p\t@Cő吔
+#define MAXFILENUM 1000 //p\t@Cő吔
 #define PATHNAMEMAX 128 //[LOfBNgpX̍ől
 #define UNDOBUFSIZE 2048 //AhDpobt@TCY
 
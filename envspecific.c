@@ -69,6 +69,32 @@ void post_run(void){
 }
 
 
+/*
+	int dma_memcpy(void* dst, void* src, int len);
+	Copy memory by DMA0 (see also main.c).
+	Regions must not be overlapped. Returns 0 if not copied.
+*/
+
+int dma_memcpy(void* dst, void* src, int len){
+	// Size registers are 16 bit
+	if (0xFFFF<len) return 0;
+	DMACONSET=0x8000;
+	DCH0CON=0x00000000;  // CHBUSY=0, CHCHNS=0, CHEN=0, CHAED=0, CHCHN=0, CHAEN=0, CHEDET=0, CHPRI=b00
+	DCH0ECON=0x00000000; // No IRQ triggers the transfer
+	DCH0SSA=((unsigned int)src)&0x1fffffff;
+	DCH0DSA=((unsigned int)dst)&0x1fffffff;
+	DCH0SSIZ=len;
+	DCH0DSIZ=len;
+	DCH0CSIZ=len;        // Whole block in a cell
+	DCH0INTCLR=0x00FF00FF;
+	DCH0CONSET=0x00000080; // CHEN=1
+	DCH0ECONSET=0x00000080; // CFORCE=1
+	// Wait until block transfer completes (CHBCIF)
+	while(!(DCH0INT&0x00000008));
+	DCH0CONCLR=0x00000080;
+	return 1;
+}
+
 /*
 	void scroll(int x, int y);
 	Scroll 
@@ -304,6 +330,31 @@ int lib_system(int a0, int a1 ,int v0, int a3, int g_gcolor, int g_prev_x, int g
 		case 41: return (int)vkey;
 		case 42: return (int)lockkey;
 		case 43: return (int)keytype;
+		// Object pool info
+		case 50: // Hits
+		case 51: // Misses
+		case 52: // Number of classes
+		case 53: // Live objects of class
+		case 54: // Pooled objects of class
+		case 55: // Pointer to class structure
+			return object_pool_info(a0-50,v0);
+		// File handle info
+		case 56: // Number of FOPEN
+		case 57: // Number of FCLOSE
+		case 58: // Bytes read
+		case 59: // Bytes written
+		case 60: // Number of reopening parked file
+			return file_handle_info(a0-56,v0);
+		// VDIM array info
+		case 61: // Number of cache hits
+		case 62: // Number of cache misses
+			return vdim_info(a0-61,(int*)v0);
+		// LOGSTART info
+		case 63: // Number of samples
+		case 64: // Number of dropped samples
+		case 65: // Bytes written
+		case 66: // Bytes per second while writing
+			return logger_info(a0-63);
 		// Pointers to gloval variables
 		case 100: return (int)&g_var_mem[0];
 		case 101: return (int)&g_rnd_seed;
@@ -11,6 +11,9 @@
 #define CPU_CLOCK_HZ 95454533
 #define PERSISTENT_RAM_SIZE (1024*100)
 
+// Valid channels of LOGSTART: ANALOG(0)-ANALOG(18) and PORTB (see lib_logsample())
+#define LOG_CHANNELS 0x000FFFFF
+
 int readbuttons();
 void scroll(int x, int y);
 void usegraphic(int mode);
@@ -20,6 +23,11 @@ void pre_run(void);
 void post_run(void);
 void err_peri_not_init(void);
 
+// Minimum size (bytes) for copying memory by DMA0 (see mem_copy()).
+// Set 0 not to use DMA.
+#define DMA_MEMCPY_MIN 0
+int dma_memcpy(void* dst, void* src, int len);
+
 // 30, 36, 40, 48, 64, 80 characters per line for Megalopa
 void printcomma(void);
 
@@ -42,6 +42,9 @@ const char* g_err_str[]={
 	"Invalid in class file",
 	"INIT method does not exist",
 	"ERR_OPTION_CLASSCODE",
+	"Size of flat array changed",
+	"Type of array changed",
+	"OPTION FLATDIM differs between files",
 };
 
 char* resolve_label(int s6){
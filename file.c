@@ -142,6 +142,8 @@ int compile_and_link_file(char* buff,char* appname){
 		// Option initialization(s)
 		g_option_nolinenum=0;
 		g_option_fastfield=0;
+		g_option_flatdim=0;
+		g_obj_class=0;
 
 		// Compile the file
 		err=compile_file();
@@ -176,6 +178,8 @@ int compile_and_link_file(char* buff,char* appname){
 		return g_fileline;
 	}
 
+	// Resolve codes to access fields in class file before link
+	if (g_compiling_class) resolve_field_codes();
 	// Link
 	err=link();
 	if (err) {
@@ -101,8 +101,9 @@ char* get_simple_float(void){
 			}
 			if (g_source[g_srcpos]=='.') {
 				// This is an object field or method to return string
-				check_obj_space(1);
-				g_object[g_objpos++]=0x8FC20000|(i*4); // lw v0,xx(s8)
+				err=field_or_var_code(i,0x8FC20000); // lw v0,xx(s8)
+				if (err) return err;
+				g_obj_class=var_class_structure(i);
 				g_srcpos++;
 				return pre_float_obj_field();
 			} else if (g_source[g_srcpos]=='(') {
@@ -114,16 +115,20 @@ char* get_simple_float(void){
 				g_srcpos++;
 				return pre_float_obj_field();
 			}
-			if (g_source[g_srcpos]!='#') return ERR_SYNTAX;
+			if (g_source[g_srcpos]!='#') {
+				// Not a float variable (see count_field_reference())
+				count_field_reference(i,-1);
+				return ERR_SYNTAX;
+			}
 			g_srcpos++;
 			if (g_source[g_srcpos]=='(') {
 				// Dimension
 				g_srcpos++;
+				if (get_dim_bits(i)!=32) return ERR_DIM_TYPE;
 				return get_dim_value(i);
 			}
-			// Simple value
-			check_obj_space(1);
-			g_object[g_objpos++]=0x8FC20000|(i*4); // lw v0,xx(s8)
+			// Simple value (or field in class file)
+			return field_or_var_code(i,0x8FC20000); // lw v0,xx(s8)
 		}
 	}
 	// No error 
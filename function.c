@@ -264,10 +264,25 @@ char* args_function(void){
 }
 
 char* system_function(void){
+	// SYSTEM(X[,Y])
 	char* err;
 	err=get_value();
 	if (err) return err;
-	g_object[g_objpos++]=0x00402021; //   addu        a0,v0,zero
+	if (g_source[g_srcpos]==',') {
+		// 2nd parameter is given as $v0
+		g_srcpos++;
+		check_obj_space(2);
+		g_object[g_objpos++]=0x27BDFFFC; // addiu       sp,sp,-4
+		g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
+		err=get_value();
+		if (err) return err;
+		check_obj_space(2);
+		g_object[g_objpos++]=0x8FA40004; // lw          a0,4(sp)
+		g_object[g_objpos++]=0x27BD0004; // addiu       sp,sp,4
+	} else {
+		check_obj_space(1);
+		g_object[g_objpos++]=0x00402021; //   addu        a0,v0,zero
+	}
 	call_lib_code(LIB_SYSTEM);
 	return 0;
 }
@@ -362,6 +377,21 @@ char* feof_function(){
 	return 0;
 }
 
+char* kvget_function(){
+	// KVGET(K$)
+	char* err;
+	err=get_string();
+	if (err) return err;
+	call_lib_code(LIB_KVSTORE | KV_GET);
+	return 0;
+}
+
+char* fgetasync_function(){
+	// Returns number of bytes remaining to be read by FGETASYNC
+	call_lib_code(LIB_FILE | FUNC_FASYNCREMAIN);
+	return 0;
+}
+
 char* playwave_function(){
 	char* err;
 	next_position();
@@ -395,6 +425,56 @@ char* exec_function(){
 	return exec_statement();
 }
 
+char* bsearch_function(){
+	// BSEARCH(A(),N,KEY[,DESC])
+	char* err;
+	int flags;
+	// Get array
+	err=get_array_param(&flags);
+	if (err) return err;
+	next_position();
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(2);
+	g_object[g_objpos++]=0x27BDFFF8; // addiu       sp,sp,-8
+	g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
+	// Get number of values
+	err=get_value();
+	if (err) return err;
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(1);
+	g_object[g_objpos++]=0xAFA20008; // sw          v0,8(sp)
+	// Get key
+	switch(flags & SORT_TYPE_MASK){
+		case SORT_FLOAT:
+			err=get_float();
+			break;
+		case SORT_STR:
+			err=get_string();
+			break;
+		case SORT_INT:
+		default:
+			err=get_value();
+			break;
+	}
+	if (err) return err;
+	next_position();
+	if (g_source[g_srcpos]==',') {
+		g_srcpos++;
+		if (!nextCodeIs("DESC")) return ERR_SYNTAX;
+		flags|=SORT_DESC;
+	}
+	call_lib_code(LIB_SORT | SORT_SEARCH | flags);
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BD0008; // addiu       sp,sp,8
+	return 0;
+}
+
+char* memcmp_function(){
+	return mem_statement_main(MEM_CMP);
+}
+
 char* readkey_function(){
 	call_lib_code(LIB_READKEY);
 	return 0;
@@ -602,6 +682,8 @@ static const void* int_func_list[]={
 	"FPUTC(",fputc_statement,
 	"FREMOVE(",fremove_statement,
 	"FEOF(",feof_function,
+	"FGETASYNC(",fgetasync_function,
+	"KVGET(",kvget_function,
 	"PLAYWAVE(",playwave_function,
 	"NEW(",new_function,
 	"SETDIR(",setdir_function,
@@ -609,6 +691,11 @@ static const void* int_func_list[]={
 	"EXEC(",exec_function,
 	"CORETIMER(",coretimer_function,
 	"READKEY(",readkey_function,
+	"MAPNEW(",mapnew_function,
+	"MAPGET(",mapget_function,
+	"MAPHAS(",maphas_function,
+	"BSEARCH(",bsearch_function,
+	"MEMCMP(",memcmp_function,
 	// Additional functions follow
 	ADDITIONAL_INT_FUNCTIONS
 };
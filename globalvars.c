@@ -94,6 +94,12 @@ int g_compiling_class;
 unsigned char g_num_classes;
 // OPTION FASTFIELD
 char g_option_fastfield;
+// OPTION FLATDIM
+char g_option_flatdim;
+// Class structure of object variable before '.' (see USEVAR xxx AS yyy)
+int* g_obj_class;
+// Size of codes removed by linker (bytes)
+int g_dead_code_size;
 
 // General purpose integer used for asigning value with pointer
 int g_temp;
@@ -64,7 +64,7 @@ void lib_serial(int baud, int parity, int bsize){
 		if (bsize==0) bsize=baud/400; // Area corresponds to ~1/40 sec (> 1/60 sec)
 		g_serial_buff_size=bsize;
 		if (g_serial_buff) free_non_temp_str((char*)g_serial_buff);
-		g_serial_buff=(short*)alloc_memory((bsize+1)/2,get_permanent_var_num());
+		g_serial_buff=(short*)alloc_perm_memory((bsize+1)/2);
 		g_serial_buff_read_pos=g_serial_buff_write_pos=0;
 		// Initialize I/O ports
 		TRISCSET=1<<14;  // Input from RC14
@@ -504,6 +504,17 @@ int lib_analog(int pos){
 	return ADC1BUF0;
 }
 
+void lib_logsample(unsigned short* data, int channels){
+	// Called in Timer1 interrupt by LOGSTART (see logger_sample() in library.c)
+	// channels bit 0-18: ANALOG(0)-ANALOG(18)
+	// channels bit 19:   PORTB (port direction and pullup are not changed)
+	int pos;
+	for(pos=0;pos<=18;pos++){
+		if (channels&(1<<pos)) *data++=lib_analog(pos);
+	}
+	if (channels&(1<<19)) *data++=PORTB&0xFFFF;
+}
+
 /*
 	Statements and functions implementations follow
 */
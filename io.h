@@ -18,6 +18,7 @@ int lib_in8h();
 int lib_in8l();
 int lib_in16();
 int lib_analog(int pos);
+void lib_logsample(unsigned short* data, int channels);
 void lib_pwm(int duty, int freq, int num);
 void lib_serial(int baud, int parity, int bsize);
 void lib_serialout(int data);
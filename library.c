@@ -27,6 +27,8 @@ static int g_prev_y=0;
 
 int lib_setdir(int mode,char* path){
 	int ret;
+	file_async_wait();
+	if (ramdisk_chdir(path)) return 0;
 	ret=FSchdir(path);
 	if (mode==LIB_SETDIR && ret) err_file();
 	return ret;
@@ -35,12 +37,40 @@ int lib_setdir(int mode,char* path){
 int lib_getdir(){
 	char* path;
 	path=calloc_memory(32,-1);
+	file_async_wait();
+	if (ramdisk_cwd()) {
+		path[0]='R';
+		path[1]=':';
+		path[2]='\\';
+		path[3]=0;
+		return (int)path;
+	}
 	FSgetcwd (path,128);
 	return (int)path;
 }
 
+static unsigned int data_block(unsigned int pos){
+	// Search DATA region from g_object[pos].
+	// Returns the position of "bgezal zero,xxxx", or g_objpos if not found.
+	unsigned int code;
+	for(;pos<g_objpos;pos++){
+		code=g_object[pos];
+		if ((code&0xFFFF0000)!=0x04110000) continue;
+		// "bgezal zero," assembly found.
+		// Check if 0x00000020,0x00000021,0x00000022, or 0x00000023 follows
+		if ((g_object[pos+1]&0xfffffffc)!=0x00000020) {// add/addu/sub/subu        zero,zero,zero
+			// If not, skip following block (it's strig).
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		// DATA region found.
+		break;
+	}
+	return pos;
+}
+
 int lib_read(int mode, unsigned int label){
-	unsigned int i,code,code2;
+	unsigned int i;
 	static unsigned int pos=0;
 	static unsigned int in_data=0;
 	static unsigned char skip=0;
@@ -73,27 +103,14 @@ int lib_read(int mode, unsigned int label){
 	}
 	// Get data
 	if (in_data==0) {
-		for(i=pos;i<g_objpos;i++){
-			code=g_object[i];
-			code2=g_object[i+1];
-			if ((code&0xFFFF0000)!=0x04110000) continue;
-			// "bgezal zero," assembly found.
-			// Check if 0x00000020,0x00000021,0x00000022, or 0x00000023 follows
-			if ((code2&0xfffffffc)!=0x00000020) {// add/addu/sub/subu        zero,zero,zero
-				// If not, skip following block (it's strig).
-				i+=code&0x0000FFFF;
-				continue;
-			}
-			// DATA region found.
-			in_data=(code&0x0000FFFF)-1;
-			pos=i+2;
-			skip=code2&0x03;
-			break;
-		}
+		i=data_block(pos);
 		if (g_objpos<=i) {
 			err_data_not_found();
 			return 0;
 		}
+		in_data=(g_object[i]&0x0000FFFF)-1;
+		pos=i+2;
+		skip=g_object[i+1]&0x03;
 	}
 	if (label) {
 		// RESTORE function. Return pointer.
@@ -155,15 +172,11 @@ char* lib_midstr(int var_num, int pos, int len){
 }
 
 void lib_clear(void){
-	int i;
 	// All variables (including temporary and permanent ones) will be integer 0
-	for(i=0;i<ALLOC_BLOCK_NUM;i++){
-		g_var_mem[i]=0;
-	}
-	// Clear memory allocation area
-	for(i=0;i<ALLOC_BLOCK_NUM;i++){
-		g_var_size[i]=0;
-	}
+	mem_set(&g_var_mem[0],0,ALLOC_BLOCK_NUM*4);
+	// Clear memory allocation area (including permanent blocks)
+	release_file_buffers();
+	set_free_area((void*)(&g_heap_mem[0]),(void*)(&g_heap_mem[g_max_mem]));
 	// Cancel PCG
 	stopPCG();
 	g_pcg_font=0;
@@ -717,16 +730,100 @@ int lib_floatfuncs(int ia0,int iv0,enum functions a1){
 	return ((int*)(&v0))[0];
 };
 
-int* lib_dim(int varnum, int argsnum, int* sp){
+/*
+	DIM A(x)=DATA LABEL and DIM A(x)=CDATA LABEL
+	The values in DATA/CDATA regions following the label are copied to the array
+	once, when the array is allocated. The position in DATA region is kept in
+	the structure below, independently from READ() and CREAD() functions.
+*/
+
+struct dim_data {
+	unsigned int pos;
+	unsigned int num;
+	unsigned int skip;
+	int flags;
+};
+
+static int dim_data_value(struct dim_data* dd){
+	unsigned int i;
+	if (dd->num==0) {
+		i=data_block(dd->pos);
+		if (g_objpos<=i) {
+			err_data_not_found();
+			return 0;
+		}
+		dd->num=(g_object[i]&0x0000FFFF)-1;
+		dd->pos=i+2;
+		dd->skip=g_object[i+1]&0x03;
+	}
+	if (dd->flags & DIM_CDATA) {
+		i=g_object[dd->pos];
+		i>>=dd->skip*8;
+		i&=0xff;
+		if ((++dd->skip)==4) {
+			dd->skip=0;
+			dd->num--;
+			dd->pos++;
+		}
+		return i;
+	} else {
+		dd->num--;
+		return g_object[dd->pos++];
+	}
+}
+
+static void dim_data_fill(void* values, int num, int shift, struct dim_data* dd){
+	int i;
+	switch(shift){
+		case 0:
+			for(i=0;i<num;i++) ((unsigned char*)values)[i]=dim_data_value(dd);
+			break;
+		case 1:
+			for(i=0;i<num;i++) ((unsigned short*)values)[i]=dim_data_value(dd);
+			break;
+		default:
+			for(i=0;i<num;i++) ((int*)values)[i]=dim_data_value(dd);
+			break;
+	}
+}
+
+int* lib_dim(int varnum, int argsnum, int* sp, int flags){
 	int i,j;
 	static int* heap;
 	// Calculate total length.
 	int len=0;  // Total length
 	int size=1; // Size of current block
-	for(i=1;i<=argsnum;i++){
+	int shift;  // 0: 8 bit, 1: 16 bit, 2: 32 bit values
+	int last;   // Length of a block in the last dimension
+	struct dim_data dd;
+	if (flags & DIM_8BIT) shift=0;
+	else if (flags & DIM_16BIT) shift=1;
+	else shift=2;
+	if (flags & DIM_FLAT) {
+		// Flat array (see get_flat_dim_value() in value.c)
+		// Sizes of 2nd, 3rd... dimensions (+1) are followed by values
+		for(i=1;i<=argsnum;i++){
+			size*=sp[i]+1;
+		}
+		heap=calloc_memory(argsnum-1+(((size<<shift)+3)>>2),varnum);
+		for(i=2;i<=argsnum;i++){
+			heap[i-2]=sp[i]+1;
+		}
+		if (flags & (DIM_DATA|DIM_CDATA)) {
+			dd.pos=(sp[argsnum+1]-(int)(&g_object[0]))>>2;
+			dd.num=0;
+			dd.flags=flags;
+			dim_data_fill(&heap[argsnum-1],size,shift,&dd);
+		}
+		return heap;
+	}
+	for(i=1;i<argsnum;i++){
 		size*=sp[i]+1;
 		len+=size;
 	}
+	// The last dimension contains values
+	last=(((sp[argsnum]+1)<<shift)+3)>>2;
+	len+=size*last;
 	// Allocate memory
 	heap=calloc_memory(len,varnum);
 	// Construct pointers
@@ -735,64 +832,1419 @@ int* lib_dim(int varnum, int argsnum, int* sp){
 	for(i=1;i<argsnum;i++){
 		size*=sp[i]+1;
 		for(j=0;j<size;j++){
-			heap[len+j]=(int)&heap[len+size+(sp[i+1]+1)*j];
+			if (i+1<argsnum) heap[len+j]=(int)&heap[len+size+(sp[i+1]+1)*j];
+			else heap[len+j]=(int)&heap[len+size+last*j];
 		}
 		len+=size;
 	}
+	if (flags & (DIM_DATA|DIM_CDATA)) {
+		// Fill the values in the last dimension
+		dd.pos=(sp[argsnum+1]-(int)(&g_object[0]))>>2;
+		dd.num=0;
+		dd.flags=flags;
+		for(j=0;j<size;j++){
+			dim_data_fill(&heap[len+last*j],sp[argsnum]+1,shift,&dd);
+		}
+	}
 	return heap;
 };
 
-int lib_file_textlen(FSFILE* fhandle){
-	char buff[128];
-	int i,textlen,len,seek;
-	seek=FSftell(fhandle);
-	len=FSfread(&buff[0],1,128,fhandle);
-	textlen=0;
-	for(i=0;i<len-1;i++){ // Read 127 bytes for supporting CRLF
-		if (buff[i]==0x0d) {
-			if (i<len && buff[i+1]==0x0a) i++;
+/*
+	SORT statement and BSEARCH() function
+	Array is sorted by introsort: quicksort with median-of-three pivot, replaced by
+	heapsort when recursion is too deep, and insertion sort for small partitions.
+	When index array is given, its values are moved together with the values of array.
+*/
+
+#define SORT_CUTOFF 16
+
+static int s_sort_flags;
+static void* s_sort_array;
+static void* s_sort_index;
+
+static int sort_get(void* array, int i, int bits){
+	switch(bits){
+		case 8:  return ((unsigned char*)array)[i];
+		case 16: return ((unsigned short*)array)[i];
+		default: return ((int*)array)[i];
+	}
+}
+
+static void sort_set(void* array, int i, int v, int bits){
+	switch(bits){
+		case 8:  ((unsigned char*)array)[i]=v; break;
+		case 16: ((unsigned short*)array)[i]=v; break;
+		default: ((int*)array)[i]=v; break;
+	}
+}
+
+#define sort_bits(f) ((f) & SORT_8BIT ? 8 : ((f) & SORT_16BIT ? 16 : 32))
+#define index_bits(f) ((f) & SORT_INDEX8 ? 8 : ((f) & SORT_INDEX16 ? 16 : 32))
+#define sort_value(i) sort_get(s_sort_array,(i),sort_bits(s_sort_flags))
+
+static int sort_cmp(int v1, int v2){
+	// Compare two values, and return plus, minus, or zero.
+	unsigned int u1,u2;
+	int ret;
+	switch(s_sort_flags & SORT_TYPE_MASK){
+		case SORT_FLOAT:
+			// Order the bit patterns of floats as unsigned integers.
+			u1=v1<0 ? ~v1 : v1|0x80000000;
+			u2=v2<0 ? ~v2 : v2|0x80000000;
+			ret=u1<u2 ? -1:(u1>u2 ? 1:0);
+			break;
+		case SORT_STR:
+			if (!v1) v1=(int)"";
+			if (!v2) v2=(int)"";
+			for(ret=0;!ret;v1++,v2++){
+				ret=((unsigned char*)v1)[0]-((unsigned char*)v2)[0];
+				if (!((char*)v1)[0]) break;
+			}
 			break;
-		} else if (buff[i]==0x0a) {
+		case SORT_INT:
+		default:
+			ret=v1<v2 ? -1:(v1>v2 ? 1:0);
 			break;
+	}
+	return (s_sort_flags & SORT_DESC) ? -ret:ret;
+}
+
+static void sort_swap(int i, int j){
+	int bits,v;
+	bits=sort_bits(s_sort_flags);
+	v=sort_get(s_sort_array,i,bits);
+	sort_set(s_sort_array,i,sort_get(s_sort_array,j,bits),bits);
+	sort_set(s_sort_array,j,v,bits);
+	if (!s_sort_index) return;
+	bits=index_bits(s_sort_flags);
+	v=sort_get(s_sort_index,i,bits);
+	sort_set(s_sort_index,i,sort_get(s_sort_index,j,bits),bits);
+	sort_set(s_sort_index,j,v,bits);
+}
+
+static void sort_insertion(int lo, int hi){
+	int i,j,v,x,bits,xbits;
+	bits=sort_bits(s_sort_flags);
+	xbits=index_bits(s_sort_flags);
+	x=0;
+	for(i=lo+1;i<=hi;i++){
+		v=sort_get(s_sort_array,i,bits);
+		if (s_sort_index) x=sort_get(s_sort_index,i,xbits);
+		for(j=i-1;lo<=j && 0<sort_cmp(sort_get(s_sort_array,j,bits),v);j--){
+			sort_set(s_sort_array,j+1,sort_get(s_sort_array,j,bits),bits);
+			if (s_sort_index) sort_set(s_sort_index,j+1,sort_get(s_sort_index,j,xbits),xbits);
+		}
+		sort_set(s_sort_array,j+1,v,bits);
+		if (s_sort_index) sort_set(s_sort_index,j+1,x,xbits);
+	}
+}
+
+static void sort_sift_down(int lo, int i, int num){
+	// Sift down i-th value in heap of num values beginning at lo
+	int child;
+	while((child=i*2+1)<num){
+		if (child+1<num && sort_cmp(sort_value(lo+child),sort_value(lo+child+1))<0) child++;
+		if (0<=sort_cmp(sort_value(lo+i),sort_value(lo+child))) break;
+		sort_swap(lo+i,lo+child);
+		i=child;
+	}
+}
+
+static void sort_heap(int lo, int hi){
+	int i,num;
+	num=hi-lo+1;
+	for(i=num/2-1;0<=i;i--){
+		sort_sift_down(lo,i,num);
+	}
+	for(i=num-1;0<i;i--){
+		sort_swap(lo,lo+i);
+		sort_sift_down(lo,0,i);
+	}
+}
+
+static void sort_intro(int lo, int hi, int depth){
+	int i,j,mid,pivot;
+	while(SORT_CUTOFF<hi-lo){
+		if (depth--<=0) {
+			// Too deep. Use heapsort.
+			sort_heap(lo,hi);
+			return;
+		}
+		// Median of three
+		mid=lo+((hi-lo)>>1);
+		if (sort_cmp(sort_value(mid),sort_value(lo))<0) sort_swap(mid,lo);
+		if (sort_cmp(sort_value(hi),sort_value(lo))<0) sort_swap(hi,lo);
+		if (sort_cmp(sort_value(hi),sort_value(mid))<0) sort_swap(hi,mid);
+		pivot=sort_value(mid);
+		// Partition (Hoare)
+		i=lo-1;
+		j=hi+1;
+		while(1){
+			do i++; while(sort_cmp(sort_value(i),pivot)<0);
+			do j--; while(0<sort_cmp(sort_value(j),pivot));
+			if (j<=i) break;
+			sort_swap(i,j);
+		}
+		// Sort smaller partition recursively, and larger one in this loop.
+		if (j-lo<hi-j) {
+			sort_intro(lo,j,depth);
+			lo=j+1;
+		} else {
+			sort_intro(j+1,hi,depth);
+			hi=j;
 		}
-		if (i==len-2) {
-			// reached the end of buffer. Read next 127 bytes
-			textlen+=127;
-			buff[0]=buff[127];
-			len=FSfread(&buff[1],1,127,fhandle);
-			// Continue with i=0
-			i=-1;
+	}
+	sort_insertion(lo,hi);
+}
+
+static void sort_check_size(void* array, int num, int bits){
+	// Check the size of array if it is assigned to a variable.
+	int i;
+	if (num<0) err_invalid_param();
+	i=get_varnum_from_address(array);
+	if (i<0) return;
+	if (((int)g_var_size[i])*32<num*bits) err_invalid_param();
+}
+
+int lib_sort(int flags, int* array, int* index, int v0){
+	// SORT statement: v0 is number of values
+	// BSEARCH() function: index is number of values and v0 is key
+	int i,num,depth,lo,hi,mid;
+	s_sort_flags=flags;
+	s_sort_array=array;
+	num=(flags & SORT_SEARCH) ? (int)index : v0;
+	sort_check_size(array,num,sort_bits(flags));
+	if (flags & SORT_SEARCH) {
+		// Binary search for the first value not less than key
+		s_sort_index=0;
+		lo=0;
+		hi=num;
+		while(lo<hi){
+			mid=lo+((hi-lo)>>1);
+			if (sort_cmp(sort_value(mid),v0)<0) lo=mid+1;
+			else hi=mid;
 		}
+		if (lo<num && !sort_cmp(sort_value(lo),v0)) return lo;
+		return -1;
+	}
+	s_sort_index=index;
+	if (index) sort_check_size(index,num,index_bits(flags));
+	// Depth limit is 2*log2(num)
+	for(i=num,depth=0;i;i>>=1) depth+=2;
+	sort_intro(0,num-1,depth);
+	return v0;
+}
+
+int lib_memory(int func, char* p1, int p2, int len){
+	// MEMCPY, MEMSET statements and MEMCMP() function
+	if (len<0) err_invalid_param();
+	if (len==0) return 0;
+	// Regions must be within RAM (destination) and within a block if in heap area.
+	if (func!=MEM_CMP && (!withinRAM(p1) || !withinRAM(p1+len-1))) err_invalid_param();
+	if (!within_heap_block(p1,len)) err_invalid_param();
+	if (func!=MEM_SET && !within_heap_block((void*)p2,len)) err_invalid_param();
+	switch(func){
+		case MEM_COPY:
+			mem_copy(p1,(void*)p2,len);
+			return len;
+		case MEM_SET:
+			mem_set(p1,p2,len);
+			return len;
+		case MEM_CMP:
+			return mem_cmp(p1,(void*)p2,len);
+		default:
+			err_unknown();
+			return 0;
 	}
-	// The last return code must be included to caluclate total length.
-	textlen+=i+1;
-	// Return to original position
-	FSfseek(fhandle,seek,SEEK_SET);
-	return textlen;
+}
+
+/*
+	Buffered file access
+	Each file handle has a buffer of FILE_BUFFER_SIZE bytes, which is allocated as a
+	permanent block when it is used first. The buffer is used for read-ahead when
+	reading, and for write-behind when writing:
+		s_fbpos[n]:   position in file corresponding to s_fbuff[n][0]
+		s_fblen[n]:   number of valid bytes in buffer (read-ahead)
+		s_fbptr[n]:   current position in buffer
+		s_fbwrite[n]: 1 when buffer contains bytes to be written
+	The current position in file is always s_fbpos[n]+s_fbptr[n]. When reading, the
+	position of FSFILE is s_fbpos[n]+s_fblen[n]. When writing, it is s_fbpos[n].
+
+	File handles
+	FILE_HANDLE_NUM files can be opened, although SD library can open only
+	FILE_SD_SLOTS files at the same time. When more files are used, the least
+	recently used file is closed temporarily ("parked") after writing its buffer,
+	and it is opened again using the stored path and position when used next.
+	The files on RAM disk (see ramdisk.c) are accessed via fdev_xxx() functions,
+	and they are never parked.
+		s_fhandle[n]: FSFILE of opened file (or handle of RAM file), or 0 if closed or parked
+		s_fflags[n]:  FHANDLE_OPEN, FHANDLE_PARKED, FHANDLE_READONLY, and FHANDLE_RAM
+		s_fpath[n]:   full path of file, or empty string if it cannot be parked
+		s_fused[n]:   value of s_fclock when the handle was used last
+		s_fstat[n][]: statistics (see file_handle_info())
+*/
+
+#define FHANDLE_OPEN     1
+#define FHANDLE_PARKED   2
+#define FHANDLE_READONLY 4
+#define FHANDLE_RAM      8
+
+#define FSTAT_OPEN   0
+#define FSTAT_CLOSE  1
+#define FSTAT_READ   2
+#define FSTAT_WRITE  3
+#define FSTAT_REOPEN 4
+#define FSTAT_NUM    5
+
+static FSFILE* s_fhandle[FILE_HANDLE_NUM];
+static char s_fflags[FILE_HANDLE_NUM];
+static char s_fpath[FILE_HANDLE_NUM][FILE_PATH_SIZE];
+static int s_fused[FILE_HANDLE_NUM];
+static int s_fclock;
+static int s_fstat[FILE_HANDLE_NUM][FSTAT_NUM];
+static int* s_fvdim[FILE_HANDLE_NUM];
+static char s_fclosing;
+static char* s_fbuff[FILE_HANDLE_NUM];
+static int s_fbpos[FILE_HANDLE_NUM];
+static short s_fblen[FILE_HANDLE_NUM];
+static short s_fbptr[FILE_HANDLE_NUM];
+static char s_fbwrite[FILE_HANDLE_NUM];
+
+static int fdev_read(int n, char* dest, int len){
+	if (s_fflags[n]&FHANDLE_RAM) return ramdisk_fread(dest,len,(int*)s_fhandle[n]);
+	return FSfread(dest,1,len,s_fhandle[n]);
+}
+
+static int fdev_write(int n, char* src, int len){
+	if (s_fflags[n]&FHANDLE_RAM) return ramdisk_fwrite(src,len,(int*)s_fhandle[n]);
+	return FSfwrite(src,1,len,s_fhandle[n]);
+}
+
+static int fdev_seek(int n, int pos){
+	if (s_fflags[n]&FHANDLE_RAM) return ramdisk_fseek((int*)s_fhandle[n],pos);
+	return FSfseek(s_fhandle[n],pos,SEEK_SET);
+}
+
+static int fdev_tell(int n){
+	if (s_fflags[n]&FHANDLE_RAM) return ramdisk_ftell((int*)s_fhandle[n]);
+	return FSftell(s_fhandle[n]);
+}
+
+static int fdev_size(int n){
+	if (s_fflags[n]&FHANDLE_RAM) return ramdisk_fsize((int*)s_fhandle[n]);
+	return s_fhandle[n]->size;
+}
+
+static void fdev_close(int n){
+	if (s_fflags[n]&FHANDLE_RAM) ramdisk_fclose((int*)s_fhandle[n]);
+	else FSfclose(s_fhandle[n]);
+}
+
+static int fbuff_sync(int n){
+	// Write the buffered bytes, and move the position of FSFILE to current position.
+	// Buffer becomes empty. Returns 0 if successful.
+	int len;
+	int err=0;
+	if (s_fbwrite[n]) {
+		len=s_fbptr[n];
+		s_fbwrite[n]=0;
+		if (len) {
+			len=fdev_write(n,s_fbuff[n],len);
+			if (len!=s_fbptr[n]) err=1;
+		}
+	} else {
+		len=s_fbptr[n];
+		// Return to current position when read-ahead bytes remain.
+		if (len!=s_fblen[n]) err=fdev_seek(n,s_fbpos[n]+len);
+	}
+	s_fbpos[n]+=len;
+	s_fbptr[n]=0;
+	s_fblen[n]=0;
+	return err;
+}
+
+static void fbuff_flush(int n){
+	// Errors are ignored when closing all files at the end of program (see FUNC_FINIT).
+	if (fbuff_sync(n) && !s_fclosing) err_file();
+}
+
+static char* fbuff_buffer(int n){
+	if (!s_fbuff[n]) s_fbuff[n]=alloc_perm_memory(FILE_BUFFER_SIZE/4);
+	return s_fbuff[n];
+}
+
+static int fbuff_fill(int n){
+	// Read ahead. Returns the number of bytes in buffer.
+	fbuff_flush(n);
+	s_fblen[n]=fdev_read(n,s_fbuff[n],FILE_BUFFER_SIZE);
+	return s_fblen[n];
+}
+
+static int fbuff_getc(int n){
+	char* buff=fbuff_buffer(n);
+	if (s_fbwrite[n]) fbuff_flush(n);
+	if (s_fblen[n]<=s_fbptr[n]) {
+		if (!fbuff_fill(n)) return -1;
+	}
+	s_fstat[n][FSTAT_READ]++;
+	return ((unsigned char*)buff)[s_fbptr[n]++];
+}
+
+static char* fbuff_append(char* str, int len, char* src, int add){
+	// Returns new temporary string with add bytes appended.
+	char* ret;
+	ret=alloc_memory((len+add+1+3)/4,-1);
+	if (len) {
+		mem_copy(ret,str,len);
+		free_temp_str(str);
+	}
+	mem_copy(&ret[len],src,add);
+	ret[len+add]=0;
+	return ret;
+}
+
+static char* fbuff_gets(int n){
+	// Read a line including CR/LF at the end.
+	// The line is copied from buffer to string directly. When the line continues
+	// to next buffer, string will be extended.
+	int i,end;
+	int len=0;
+	char* str=0;
+	char* buff=fbuff_buffer(n);
+	if (s_fbwrite[n]) fbuff_flush(n);
+	while(1){
+		if (s_fblen[n]<=s_fbptr[n]) {
+			if (!fbuff_fill(n)) break;
+		}
+		// Search CR/LF in buffer
+		end=0;
+		for(i=s_fbptr[n];i<s_fblen[n];i++){
+			if (buff[i]==0x0a) {
+				end=1;
+				break;
+			} else if (buff[i]==0x0d) {
+				end=1;
+				if (i+1<s_fblen[n] && buff[i+1]==0x0a) i++;
+				break;
+			}
+		}
+		if (end) i++;
+		str=fbuff_append(str,len,&buff[s_fbptr[n]],i-s_fbptr[n]);
+		len+=i-s_fbptr[n];
+		s_fbptr[n]=i;
+		if (!end) continue;
+		// Check LF after CR at the end of buffer
+		if (buff[i-1]==0x0d && s_fbptr[n]==s_fblen[n]) {
+			if (fbuff_fill(n) && buff[0]==0x0a) {
+				str=fbuff_append(str,len,&buff[0],1);
+				len++;
+				s_fbptr[n]=1;
+			}
+		}
+		break;
+	}
+	if (!str) {
+		// Empty string at the end of file
+		str=alloc_memory(1,-1);
+		str[0]=0;
+	}
+	s_fstat[n][FSTAT_READ]+=len;
+	return str;
+}
+
+static int fbuff_read(int n, char* dest, int len){
+	int i;
+	int total=0;
+	char* buff=fbuff_buffer(n);
+	if (s_fbwrite[n]) fbuff_flush(n);
+	while(0<len){
+		i=s_fblen[n]-s_fbptr[n];
+		if (i<=0) {
+			fbuff_flush(n);
+			if (FILE_BUFFER_SIZE<=len) {
+				// Read directly to destination
+				i=fdev_read(n,dest,len);
+				s_fbpos[n]+=i;
+				total+=i;
+				break;
+			}
+			// Read ahead
+			if (!fbuff_fill(n)) break;
+			continue;
+		}
+		if (len<i) i=len;
+		mem_copy(dest,&buff[s_fbptr[n]],i);
+		s_fbptr[n]+=i;
+		dest+=i;
+		len-=i;
+		total+=i;
+	}
+	s_fstat[n][FSTAT_READ]+=total;
+	return total;
+}
+
+static int fbuff_write(int n, char* src, int len){
+	int i;
+	int total=len;
+	char* buff=fbuff_buffer(n);
+	if (!s_fbwrite[n]) {
+		fbuff_flush(n);
+		s_fbwrite[n]=1;
+	}
+	while(0<len){
+		i=FILE_BUFFER_SIZE-s_fbptr[n];
+		if (i<=0) {
+			// Buffer is full
+			fbuff_flush(n);
+			s_fbwrite[n]=1;
+			continue;
+		}
+		if (s_fbptr[n]==0 && FILE_BUFFER_SIZE<=len) {
+			// Write directly from source
+			i=fdev_write(n,src,len);
+			s_fbpos[n]+=i;
+			total=total-len+i;
+			break;
+		}
+		if (len<i) i=len;
+		mem_copy(&buff[s_fbptr[n]],src,i);
+		s_fbptr[n]+=i;
+		src+=i;
+		len-=i;
+	}
+	s_fstat[n][FSTAT_WRITE]+=total;
+	return total;
+}
+
+static int fbuff_seek(int n, int pos){
+	int err;
+	if (!s_fbwrite[n] && s_fbpos[n]<=pos && pos<=s_fbpos[n]+s_fblen[n]) {
+		// Position is in read-ahead buffer
+		s_fbptr[n]=pos-s_fbpos[n];
+		return 0;
+	}
+	fbuff_flush(n);
+	err=fdev_seek(n,pos);
+	s_fbpos[n]=fdev_tell(n);
+	return err;
+}
+
+static int fbuff_len(int n){
+	// Buffered bytes may be after the end of file
+	int len=s_fbpos[n]+s_fbptr[n];
+	if (len<fdev_size(n)) len=fdev_size(n);
+	return len;
+}
+
+static void fbuff_park(int n){
+	// Close file temporarily. Current position is kept in s_fbpos[n].
+	fbuff_flush(n);
+	FSfclose(s_fhandle[n]);
+	s_fhandle[n]=0;
+	s_fflags[n]|=FHANDLE_PARKED;
+	if (s_fbuff[n]) free_perm_str(s_fbuff[n]);
+	s_fbuff[n]=0;
+}
+
+static void fbuff_free_slot(int n){
+	// Park the least recently used file if SD library cannot open more files.
+	// Handle n is not parked.
+	int i,lru;
+	int num=0;
+	lru=-1;
+	for(i=0;i<FILE_HANDLE_NUM;i++){
+		if (!s_fhandle[i] || (s_fflags[i]&FHANDLE_RAM)) continue;
+		num++;
+		if (i==n || !s_fpath[i][0]) continue;
+		if (lru<0 || s_fused[i]-s_fused[lru]<0) lru=i;
+	}
+	if (num<FILE_SD_SLOTS || lru<0) return;
+	fbuff_park(lru);
+}
+
+static FSFILE* fbuff_handle(int n){
+	// Returns FSFILE of handle n. Parked file is opened again.
+	FSFILE* fhandle;
+	s_fused[n]=++s_fclock;
+	if (s_fhandle[n]) return s_fhandle[n];
+	if (!(s_fflags[n]&FHANDLE_PARKED)) return 0;
+	fbuff_free_slot(n);
+	fhandle=FSfopen(s_fpath[n],(s_fflags[n]&FHANDLE_READONLY) ? "r":"r+");
+	if (!fhandle) {
+		err_file();
+		return 0;
+	}
+	FSfseek(fhandle,s_fbpos[n],SEEK_SET);
+	s_fhandle[n]=fhandle;
+	s_fflags[n]&=~FHANDLE_PARKED;
+	s_fstat[n][FSTAT_REOPEN]++;
+	return fhandle;
+}
+
+static void fbuff_path(int n, const char* name){
+	// Store full path of file for reopening.
+	// Empty string is stored if path is too long.
+	int i,len;
+	char* path=s_fpath[n];
+	for(len=0;name[len];len++);
+	i=0;
+	if (name[0]!='/' && name[0]!='\\') {
+		// Relative path
+		if (!FSgetcwd(path,FILE_PATH_SIZE)) len=FILE_PATH_SIZE;
+		for(i=0;i<FILE_PATH_SIZE-2 && path[i];i++);
+		if (i && path[i-1]!='/' && path[i-1]!='\\') path[i++]='\\';
+	}
+	if (FILE_PATH_SIZE<=i+len+1) {
+		path[0]=0;
+		return;
+	}
+	for(len=0;path[i+len]=name[len];len++);
+}
+
+static int fbuff_open(int n, const char* name, const char* mode){
+	// Open file and initialize handle n. Returns 0 if failed.
+	FSFILE* fhandle;
+	if (ramdisk_file(name)) {
+		// File on RAM disk
+		fhandle=(FSFILE*)ramdisk_fopen(name,mode);
+		if (!fhandle) return 0;
+		s_fpath[n][0]=0;
+		s_fflags[n]=FHANDLE_OPEN|FHANDLE_RAM;
+	} else {
+		fbuff_free_slot(n);
+		fhandle=FSfopen(name,mode);
+		if (!fhandle) return 0;
+		fbuff_path(n,name);
+		s_fflags[n]=FHANDLE_OPEN;
+	}
+	// Buffer will be allocated when used.
+	s_fhandle[n]=fhandle;
+	if ((mode[0]=='r' || mode[0]=='R') && mode[1]!='+') s_fflags[n]|=FHANDLE_READONLY;
+	s_fbuff[n]=0;
+	s_fbpos[n]=fdev_tell(n);
+	s_fblen[n]=0;
+	s_fbptr[n]=0;
+	s_fbwrite[n]=0;
+	s_fused[n]=++s_fclock;
+	s_fstat[n][FSTAT_OPEN]++;
+	return 1;
+}
+
+static void fbuff_close(int n){
+	int err=0;
+	if (s_fhandle[n]) {
+		// Write buffered bytes before closing file.
+		err=fbuff_sync(n);
+		fdev_close(n);
+	}
+	if (s_fbuff[n]) free_perm_str(s_fbuff[n]);
+	s_fbuff[n]=0;
+	s_fhandle[n]=0;
+	s_fflags[n]=0;
+	s_fstat[n][FSTAT_CLOSE]++;
+	if (err) err_file();
+}
+
+/*
+	Background reading (FGETASYNC)
+	Only one reading can be active at the same time. When FGETASYNC is called, the
+	bytes in read-ahead buffer are copied, and others are read directly to the
+	destination by FILE_ASYNC_SLICE bytes every 1/60 sec in CS0 interrupt (see
+	CS0Handler()). FILE interrupt is raised when all bytes are read or the end of
+	file is reached. Before other access to SD card in main routine, the reading is
+	completed there (see file_async_wait()).
+		s_fasync:   file handle+1 used for reading, or 0 if not active
+		s_fadest:   destination address of next slice
+		s_faremain: number of bytes to be read
+*/
+
+static volatile char s_fasync;
+static char* volatile s_fadest;
+static volatile int s_faremain;
+
+static void fasync_read(int len){
+	// Read a slice. Called in CS0 interrupt or main routine with CS0 interrupt disabled.
+	int i;
+	int n=s_fasync-1;
+	if (s_faremain<len) len=s_faremain;
+	i=fdev_read(n,s_fadest,len);
+	s_fbpos[n]+=i;
+	s_fstat[n][FSTAT_READ]+=i;
+	s_fadest+=i;
+	s_faremain-=i;
+	// End of file
+	if (i<len) s_faremain=0;
+	if (s_faremain) return;
+	s_fasync=0;
+	raise_interrupt_flag(INTERRUPT_FILE);
+}
+
+static int fasync_start(int n, char* dest, int len){
+	// FGETASYNC ADDR,LEN
+	int i;
+	if (len<0) err_invalid_param();
+	if (len) {
+		if (!withinRAM(dest) || !withinRAM(dest+len-1)) err_invalid_param();
+		if (!within_heap_block(dest,len)) err_invalid_param();
+	}
+	// Copy bytes in read-ahead buffer. Then, the position of FSFILE will be current position.
+	i=s_fbwrite[n] ? 0 : s_fblen[n]-s_fbptr[n];
+	if (len<i) i=len;
+	if (0<i) fbuff_read(n,dest,i);
+	else i=0;
+	fbuff_flush(n);
+	// The others will be read in CS0 interrupt.
+	s_fadest=dest+i;
+	s_faremain=len-i;
+	s_fasync=n+1;
+	if (s_faremain) IEC0bits.CS0IE=1;
+	else file_async_wait(); // Raise FILE interrupt here
+	return len;
+}
+
+void file_async_interrupt(void){
+	// Called every 1/60 sec in CS0 interrupt
+	if (s_fasync) fasync_read(FILE_ASYNC_SLICE);
+}
+
+void file_async_wait(void){
+	// Complete background reading before accessing SD card in main routine.
+	// CS0 interrupt is disabled not to access SD card at the same time.
+	int ie;
+	if (!s_fasync) return;
+	ie=IEC0bits.CS0IE;
+	IEC0bits.CS0IE=0;
+	while(s_fasync) fasync_read(FILE_BUFFER_SIZE);
+	IEC0bits.CS0IE=ie;
+}
+
+int file_async_remaining(void){
+	// FGETASYNC() function
+	return s_faremain;
+}
+
+/*
+	VDIM array
+	Values of array are stored in a file. Some pages of the file are cached in the
+	block allocated for the array variable:
+		vdim[0]: pointer to lib_vdim() as signature
+		vdim[1]: variable number
+		vdim[2]: index of file handle
+		vdim[3]: number of values
+		vdim[4]: 0: 8 bit, 1: 16 bit, 2: 32 bit values
+		vdim[5]: counter for LRU
+		vdim[6]: number of cache hits
+		vdim[7]: number of cache misses
+		vdim[8]: page number of the most recently used page
+		vdim[9]: slot number of the most recently used page
+		vdim[10]-: VDIM_PAGES slots (3 words each):
+			slot[0]: page number, or -1 if not used
+			slot[1]: value of counter when used last
+			slot[2]: 1 if page has been changed
+		VDIM_PAGES pages (VDIM_PAGE_SIZE bytes each) follow the slots.
+	Changed pages are written to file when replaced, and when the file is closed by
+	FCLOSE, CLEAR, or at the end of program.
+*/
+
+#define VDIM_PAGE_SIZE  512
+#define VDIM_PAGE_SHIFT 9
+#define VDIM_HEADER     10
+
+#define vdim_slot(vdim,i) (&(vdim)[VDIM_HEADER+(i)*3])
+#define vdim_data(vdim,i) (((char*)&(vdim)[VDIM_HEADER+VDIM_PAGES*3])+(i)*VDIM_PAGE_SIZE)
+
+static int vdim_valid(int* vdim){
+	// Check if the block is still used for VDIM array
+	if (!vdim || vdim[0]!=(int)lib_vdim) return 0;
+	return g_var_mem[vdim[1]]==(int)vdim;
+}
+
+static void vdim_write_page(int* vdim, int i){
+	int pos,len,n;
+	int* slot=vdim_slot(vdim,i);
+	if (!slot[2]) return;
+	slot[2]=0;
+	n=vdim[2];
+	pos=slot[0]<<VDIM_PAGE_SHIFT;
+	// The last page may be shorter than VDIM_PAGE_SIZE
+	len=(vdim[3]<<vdim[4])-pos;
+	if (VDIM_PAGE_SIZE<len) len=VDIM_PAGE_SIZE;
+	fbuff_handle(n);
+	fbuff_seek(n,pos);
+	if (fbuff_write(n,vdim_data(vdim,i),len)!=len && !s_fclosing) err_file();
+}
+
+static char* vdim_page(int* vdim, int page){
+	// Returns pointer to cached page. The page is read from file if not cached.
+	int i,n;
+	int* slot;
+	char* data;
+	for(i=0;i<VDIM_PAGES;i++){
+		if (vdim_slot(vdim,i)[0]==page) break;
+	}
+	if (i<VDIM_PAGES) {
+		vdim[6]++;
+	} else {
+		vdim[7]++;
+		file_async_wait();
+		// Replace the least recently used page
+		i=0;
+		for(n=1;n<VDIM_PAGES;n++){
+			if (vdim_slot(vdim,n)[1]-vdim_slot(vdim,i)[1]<0) i=n;
+		}
+		vdim_write_page(vdim,i);
+		slot=vdim_slot(vdim,i);
+		slot[0]=-1;
+		n=vdim[2];
+		data=vdim_data(vdim,i);
+		fbuff_handle(n);
+		fbuff_seek(n,page<<VDIM_PAGE_SHIFT);
+		n=fbuff_read(n,data,VDIM_PAGE_SIZE);
+		if (n<VDIM_PAGE_SIZE) mem_set(data+n,0,VDIM_PAGE_SIZE-n);
+		slot[0]=page;
+	}
+	vdim_slot(vdim,i)[1]=++vdim[5];
+	vdim[8]=page;
+	vdim[9]=i;
+	return vdim_data(vdim,i);
+}
+
+static void vdim_close(int n){
+	// Write changed pages of VDIM array using file handle n, and detach the array.
+	int i;
+	int* vdim=s_fvdim[n];
+	s_fvdim[n]=0;
+	if (!vdim_valid(vdim)) return;
+	for(i=0;i<VDIM_PAGES;i++){
+		vdim_write_page(vdim,i);
+	}
+	vdim[0]=0;
+}
+
+static int* vdim_new(int flags, int varnum, int num, char* name, int handle){
+	// VDIM A(N),"FILE"[,H]
+	int i,n,len,size,shift;
+	int* vdim;
+	char* data;
+	if (flags & VDIM_8BIT) shift=0;
+	else if (flags & VDIM_16BIT) shift=1;
+	else shift=2;
+	if (num<0) err_invalid_param();
+	num++;
+	file_async_wait();
+	// Close the VDIM array previously assigned to the variable
+	vdim=(int*)g_var_mem[varnum];
+	if (vdim_valid(vdim)) {
+		n=vdim[2];
+		vdim_close(n);
+		fbuff_close(n);
+	}
+	// Select file handle. When not designated, use the last free one.
+	if (handle) {
+		if (handle<0 || FILE_HANDLE_NUM<handle) err_invalid_param();
+		n=handle-1;
+		if (s_fflags[n]) err_file();
+	} else {
+		for(n=FILE_HANDLE_NUM-1;0<=n;n--){
+			if (!s_fflags[n]) break;
+		}
+		if (n<0) err_file();
+	}
+	// Open file, or create it if not exist.
+	if (!fbuff_open(n,name,"r+") && !fbuff_open(n,name,"w+")) err_file();
+	// Allocate the block for array variable
+	vdim=alloc_memory(VDIM_HEADER+VDIM_PAGES*(3+VDIM_PAGE_SIZE/4),varnum);
+	vdim[0]=(int)lib_vdim;
+	vdim[1]=varnum;
+	vdim[2]=n;
+	vdim[3]=num;
+	vdim[4]=shift;
+	vdim[5]=0;
+	vdim[6]=0;
+	vdim[7]=0;
+	vdim[8]=-1;
+	vdim[9]=0;
+	for(i=0;i<VDIM_PAGES;i++){
+		vdim_slot(vdim,i)[0]=-1;
+		vdim_slot(vdim,i)[1]=0;
+		vdim_slot(vdim,i)[2]=0;
+	}
+	// Extend the file to the size of array
+	size=num<<shift;
+	i=fbuff_len(n);
+	if (i<size) {
+		data=vdim_data(vdim,0);
+		mem_set(data,0,VDIM_PAGE_SIZE);
+		fbuff_seek(n,i);
+		while(i<size){
+			len=size-i;
+			if (VDIM_PAGE_SIZE<len) len=VDIM_PAGE_SIZE;
+			if (fbuff_write(n,data,len)!=len) err_file();
+			i+=len;
+		}
+		fbuff_flush(n);
+	}
+	s_fvdim[n]=vdim;
+	return vdim;
+}
+
+int lib_vdim(int flags, int varnum, int* params, int v0){
+	int i;
+	int* vdim;
+	char* data;
+	switch(flags & VDIM_FUNC_MASK){
+		case VDIM_NEW:
+			return (int)vdim_new(flags,varnum,params[1],(char*)params[2],v0);
+		case VDIM_GET:
+			i=v0;
+			break;
+		case VDIM_SET:
+			i=params[1];
+			break;
+		default:
+			err_unknown();
+			return 0;
+	}
+	// Check array
+	vdim=(int*)g_var_mem[varnum];
+	if (!vdim || vdim[0]!=(int)lib_vdim) err_file();
+	if (i<0 || vdim[3]<=i) err_invalid_param();
+	i<<=vdim[4];
+	// Fast path for the most recently used page
+	if ((i>>VDIM_PAGE_SHIFT)==vdim[8]) {
+		vdim[6]++;
+		data=vdim_data(vdim,vdim[9]);
+	} else {
+		data=vdim_page(vdim,i>>VDIM_PAGE_SHIFT);
+	}
+	data+=i&(VDIM_PAGE_SIZE-1);
+	if ((flags & VDIM_FUNC_MASK)==VDIM_SET) {
+		vdim_slot(vdim,vdim[9])[2]=1;
+		switch(vdim[4]){
+			case 0:  ((unsigned char*)data)[0]=v0; break;
+			case 1:  ((unsigned short*)data)[0]=v0; break;
+			default: ((int*)data)[0]=v0; break;
+		}
+		return v0;
+	}
+	switch(vdim[4]){
+		case 0:  return ((unsigned char*)data)[0];
+		case 1:  return ((unsigned short*)data)[0];
+		default: return ((int*)data)[0];
+	}
+}
+
+int vdim_info(int info, int* vdim){
+	// Statistics of VDIM array (see SYSTEM(61) and SYSTEM(62))
+	if (!vdim_valid(vdim)) return 0;
+	switch(info){
+		case 0: return vdim[6];
+		case 1: return vdim[7];
+		default: return 0;
+	}
+}
+
+/*
+	Key-value store (KVOPEN, KVPUT, and KVGET())
+	Integer values with string keys are stored in a log file. KVPUT appends a
+	record, and closes the file temporarily (see fbuff_park()) so that the record
+	and the directory entry are written to SD card. KVOPEN reads all records to
+	build the index in heap area (see lib_map()), so KVGET() doesn't access SD
+	card. Broken records at the end of file (e.g. by power failure while writing)
+	are ignored, and will be overwritten.
+	Record structure:
+		1 byte:  length of key (1-KV_KEY_MAX)
+		n bytes: key
+		4 bytes: value (little endian)
+		2 bytes: CRC-16-CCITT of all bytes above (little endian)
+	When the log becomes larger than KV_COMPACT_SIZE and twice of valid records,
+	valid records are written to a temporary file, which replaces the log. If
+	power fails before renaming it, the temporary file is used when opening.
+		s_kvhandle: file handle+1 of log, or 0 if not opened
+		s_kvmap:    index (map of key and value)
+		s_kvlive:   total bytes of valid records
+		s_kvpath:   full path of log
+		s_kvtemp:   full path of temporary file
+*/
+
+#define KV_KEY_MAX      64
+#define KV_COMPACT_SIZE 4096
+#define KV_TEMP_NAME    "~KVTEMP.TMP"
+
+static int s_kvhandle;
+static int* s_kvmap;
+static int s_kvlive;
+static char s_kvpath[FILE_PATH_SIZE];
+static char s_kvtemp[FILE_PATH_SIZE];
+static unsigned char s_kvrecord[KV_KEY_MAX+7];
+
+static int kv_crc(unsigned char* data, int len){
+	// CRC-16-CCITT
+	int i;
+	unsigned short crc=0xFFFF;
+	while(0<len--){
+		crc^=(*data++)<<8;
+		for(i=0;i<8;i++) crc=(crc&0x8000) ? (crc<<1)^0x1021 : crc<<1;
+	}
+	return crc;
+}
+
+static int kv_record(char* key, int value){
+	// Make a record in s_kvrecord. Returns the size of record.
+	int len,crc;
+	for(len=0;key[len];len++);
+	if (len<1 || KV_KEY_MAX<len) err_invalid_param();
+	s_kvrecord[0]=len;
+	mem_copy(&s_kvrecord[1],key,len);
+	s_kvrecord[len+1]=value;
+	s_kvrecord[len+2]=value>>8;
+	s_kvrecord[len+3]=value>>16;
+	s_kvrecord[len+4]=value>>24;
+	crc=kv_crc(s_kvrecord,len+5);
+	s_kvrecord[len+5]=crc;
+	s_kvrecord[len+6]=crc>>8;
+	return len+7;
+}
+
+static int kv_map(int func, char* key, int value){
+	int params[3];
+	params[1]=(int)s_kvmap;
+	params[2]=(int)key;
+	return lib_map(func|MAP_STRKEY,params,(func==MAP_SET) ? value:(int)key);
+}
+
+static char* kv_name(void){
+	// File name of log without directory (see kv_compact())
+	int i;
+	char* name=s_kvpath;
+	for(i=0;s_kvpath[i];i++){
+		if (s_kvpath[i]=='\\' || s_kvpath[i]=='/') name=&s_kvpath[i+1];
+	}
+	return name;
+}
+
+static void kv_write(int key, int value){
+	// Write a valid record to temporary file (see kv_compact())
+	int len=kv_record((char*)key,value);
+	if (fbuff_write(s_kvhandle-1,(char*)s_kvrecord,len)!=len) err_file();
+	s_kvlive+=len;
+}
+
+static void kv_close(int release){
+	// The index is deleted unless heap area will be cleared.
+	int n=s_kvhandle-1;
+	if (!s_kvhandle) return;
+	s_kvhandle=0;
+	if (s_fflags[n]) fbuff_close(n);
+	if (release) map_delete(s_kvmap);
+	s_kvmap=0;
+}
+
+static void kv_compact(void){
+	// Write all valid records to temporary file, and replace the log with it.
+	int n=s_kvhandle-1;
+	int err;
+	FSFILE* fhandle;
+	fbuff_close(n);
+	if (!fbuff_open(n,s_kvtemp,"w")) err_file();
+	s_kvlive=0;
+	map_foreach(s_kvmap,kv_write);
+	fbuff_close(n);
+	if (FSremove(s_kvpath)) err_file();
+	fbuff_free_slot(n);
+	fhandle=FSfopen(s_kvtemp,"r+");
+	if (!fhandle) err_file();
+	err=FSrename(kv_name(),fhandle);
+	FSfclose(fhandle);
+	if (err) err_file();
+	// Open the log again, and following records will be appended.
+	if (!fbuff_open(n,s_kvpath,"r+")) err_file();
+	fbuff_seek(n,fbuff_len(n));
+}
+
+static void kv_open(char* name){
+	// KVOPEN F$
+	int n,i,len,pos,value;
+	FSFILE* fhandle;
+	unsigned char* rec=s_kvrecord;
+	file_async_wait();
+	kv_close(1);
+	// The log must be on SD card.
+	if (ramdisk_file(name)) err_invalid_param();
+	// Use the last free file handle
+	for(n=FILE_HANDLE_NUM-1;0<=n;n--){
+		if (!s_fflags[n]) break;
+	}
+	if (n<0) err_file();
+	// Full paths of log and temporary file
+	fbuff_path(n,name);
+	for(i=0;s_kvpath[i]=s_fpath[n][i];i++);
+	if (!i) err_invalid_param();
+	for(len=0;KV_TEMP_NAME[len];len++);
+	pos=kv_name()-s_kvpath;
+	if (FILE_PATH_SIZE<=pos+len) err_invalid_param();
+	mem_copy(s_kvtemp,s_kvpath,pos);
+	mem_copy(&s_kvtemp[pos],KV_TEMP_NAME,len+1);
+	// Check temporary file left by compaction.
+	// If the log was removed, the temporary file will be the log.
+	fbuff_free_slot(n);
+	fhandle=FSfopen(s_kvpath,"r");
+	if (fhandle) {
+		FSfclose(fhandle);
+		FSremove(s_kvtemp);
+	} else {
+		fhandle=FSfopen(s_kvtemp,"r+");
+		if (fhandle) {
+			FSrename(kv_name(),fhandle);
+			FSfclose(fhandle);
+		}
+	}
+	// Open the log, or create it if not exist.
+	if (!fbuff_open(n,s_kvpath,"r+") && !fbuff_open(n,s_kvpath,"w+")) err_file();
+	s_kvhandle=n+1;
+	s_kvmap=(int*)lib_map(MAP_NEW,0,0);
+	s_kvlive=0;
+	// Read all valid records
+	pos=0;
+	while(1){
+		len=fbuff_getc(n);
+		if (len<1 || KV_KEY_MAX<len) break;
+		rec[0]=len;
+		if (fbuff_read(n,(char*)&rec[1],len+6)!=len+6) break;
+		if (kv_crc(rec,len+5)!=(rec[len+5]|(rec[len+6]<<8))) break;
+		value=rec[len+1]|(rec[len+2]<<8)|(rec[len+3]<<16)|(rec[len+4]<<24);
+		rec[len+1]=0;
+		if (!kv_map(MAP_HAS,(char*)&rec[1],0)) s_kvlive+=len+7;
+		kv_map(MAP_SET,(char*)&rec[1],value);
+		pos+=len+7;
+	}
+	// Following records will be written after the last valid one.
+	fbuff_seek(n,pos);
+	fbuff_park(n);
+}
+
+static void kv_put(char* key, int value){
+	// KVPUT K$,V
+	int n=s_kvhandle-1;
+	int len;
+	if (!s_kvhandle) err_file();
+	len=kv_record(key,value);
+	if (!kv_map(MAP_HAS,key,0)) {
+		s_kvlive+=len;
+	} else if (kv_map(MAP_GET,key,0)==value) {
+		// Nothing to write
+		return;
+	}
+	file_async_wait();
+	fbuff_handle(n);
+	if (fbuff_write(n,(char*)s_kvrecord,len)!=len) err_file();
+	kv_map(MAP_SET,key,value);
+	if (KV_COMPACT_SIZE<fbuff_len(n) && s_kvlive*2<fbuff_len(n)) kv_compact();
+	// Close the file temporarily to write the record and the directory entry.
+	fbuff_park(n);
+}
+
+int lib_kvstore(int func, int* params, int v0){
+	switch(func){
+		case KV_OPEN:
+			kv_open((char*)v0);
+			return 0;
+		case KV_PUT:
+			kv_put((char*)params[1],v0);
+			return v0;
+		case KV_GET:
+			if (!s_kvhandle) err_file();
+			return kv_map(MAP_GET,(char*)v0,0);
+		default:
+			err_unknown();
+			return 0;
+	}
+}
+
+/*
+	Data logger (LOGSTART and LOGSTOP)
+	Timer1 interrupt samples the channels to one of two buffers (see
+	logger_sample() and lib_logsample() in io.c). When a buffer becomes full, the
+	other one is used for following samples, and CS1 interrupt (lower priority
+	than Timer1) is raised to write the full buffer to the log file (see
+	logger_flush() and CS1Handler()). CS1 interrupt is disabled when SD card is
+	used in main routine (see _call_library()), and CS0 interrupt (FGETASYNC and
+	PLAYWAVE) is disabled while writing. When both buffers are full, samples are
+	dropped. The log file is never parked, as its path is not stored.
+	Each sample consists of 16 bit values (little endian) of channels. Valid bits
+	of channels are LOG_CHANNELS defined in envspecific.h. Timer1 is shared with
+	USETIMER, so USETIMER cannot be used while logging (see lib_usetimer()), and
+	LOGSTART cannot be used while Timer1 is running.
+		s_loghandle:  file handle+1 of log file, or 0 if not logging
+		s_logbuff[]:  buffers (permanent blocks)
+		s_logcur:     index of buffer used for sampling
+		s_logpos:     number of bytes in current buffer
+		s_logpending: number of bytes in the other buffer to be written, or 0
+		s_logstat[]:  statistics (see logger_info())
+*/
+
+#define LOG_MAX_RATE 20000
+
+#define LOGSTAT_SAMPLES 0
+#define LOGSTAT_DROPPED 1
+#define LOGSTAT_BYTES   2
+#define LOGSTAT_USEC    3
+#define LOGSTAT_ERROR   4
+#define LOGSTAT_NUM     5
+
+static volatile int s_loghandle;
+static char* s_logbuff[2];
+static int s_logchannels;
+static int s_logsize;
+static volatile int s_logcur;
+static volatile int s_logpos;
+static volatile int s_logpending;
+static volatile int s_logstat[LOGSTAT_NUM];
+
+static int log_swap(void){
+	// Change buffer, and raise CS1 interrupt to write the full one.
+	// Returns 0 if the other buffer has not been written yet.
+	if (s_logpending) return 0;
+	s_logpending=s_logpos;
+	s_logcur^=1;
+	s_logpos=0;
+	IFS0bits.CS1IF=1;
+	return 1;
+}
+
+int logger_sample(void){
+	// Called in Timer1 interrupt. Returns 0 if not logging.
+	if (!s_loghandle) return 0;
+	if (LOG_BUFFER_SIZE<s_logpos+s_logsize && !log_swap()) {
+		s_logstat[LOGSTAT_DROPPED]++;
+		return 1;
+	}
+	lib_logsample((unsigned short*)(s_logbuff[s_logcur]+s_logpos),s_logchannels);
+	s_logpos+=s_logsize;
+	s_logstat[LOGSTAT_SAMPLES]++;
+	// Change buffer as soon as possible
+	if (LOG_BUFFER_SIZE<s_logpos+s_logsize) log_swap();
+	return 1;
+}
+
+static void log_write(char* buff, int len){
+	// Write bytes to log file, and measure the time using core timer.
+	int i;
+	int n=s_loghandle-1;
+	unsigned int t1,t2;
+	asm volatile("mfc0 %0,$9":"=r"(t1));
+	i=fdev_write(n,buff,len);
+	asm volatile("mfc0 %0,$9":"=r"(t2));
+	// Core timer counts at CPU_CLOCK_HZ/2
+	s_logstat[LOGSTAT_USEC]+=(t2-t1)*20/(CPU_CLOCK_HZ/100000);
+	s_logstat[LOGSTAT_BYTES]+=i;
+	s_fstat[n][FSTAT_WRITE]+=i;
+	if (i!=len) s_logstat[LOGSTAT_ERROR]=1;
+}
+
+void logger_flush(void){
+	// Called in CS1 interrupt. Write the full buffer.
+	// CS0 interrupt is disabled not to access SD card at the same time.
+	int ie;
+	if (!s_logpending) return;
+	ie=IEC0bits.CS0IE;
+	IEC0bits.CS0IE=0;
+	log_write(s_logbuff[s_logcur^1],s_logpending);
+	s_logpending=0;
+	IEC0bits.CS0IE=ie;
+}
+
+int logger_pending(void){
+	return s_logpending;
+}
+
+int logger_active(void){
+	return s_loghandle;
+}
+
+static void log_stop(int release){
+	// Stop sampling, write all samples, and close log file.
+	// Buffers are deleted unless heap area will be cleared.
+	int n=s_loghandle-1;
+	int ie;
+	if (!s_loghandle) return;
+	T1CON=0x0000;
+	IEC0bits.T1IE=0;
+	ie=IEC0bits.CS1IE;
+	IEC0bits.CS1IE=0;
+	logger_flush();
+	log_write(s_logbuff[s_logcur],s_logpos);
+	s_loghandle=0;
+	IEC0bits.CS1IE=ie;
+	if (s_fflags[n]) fbuff_close(n);
+	if (release) {
+		free_perm_str(s_logbuff[0]);
+		free_perm_str(s_logbuff[1]);
+	}
+	s_logbuff[0]=s_logbuff[1]=0;
+	if (s_logstat[LOGSTAT_ERROR] && !s_fclosing) err_file();
+}
+
+static void log_start(char* name, int rate, int channels){
+	// LOGSTART F$,RATE,CHANNELS
+	int n,i;
+	file_async_wait();
+	log_stop(1);
+	// Timer1 is already used by USETIMER.
+	if (T1CONbits.ON) err_invalid_param();
+	if (rate<1 || LOG_MAX_RATE<rate) err_invalid_param();
+	if (!channels || (channels&~LOG_CHANNELS)) err_invalid_param();
+	// Log file must be on SD card, as RAM disk uses heap area.
+	if (ramdisk_file(name)) err_invalid_param();
+	// Use the last free file handle
+	for(n=FILE_HANDLE_NUM-1;0<=n;n--){
+		if (!s_fflags[n]) break;
+	}
+	if (n<0) err_file();
+	if (!fbuff_open(n,name,"w")) err_file();
+	// Log file is written in CS1 interrupt, so it must not be parked.
+	s_fpath[n][0]=0;
+	s_logbuff[0]=(char*)alloc_perm_memory(LOG_BUFFER_SIZE/4);
+	s_logbuff[1]=(char*)alloc_perm_memory(LOG_BUFFER_SIZE/4);
+	s_logchannels=channels;
+	for(s_logsize=0;channels;channels&=channels-1) s_logsize+=2;
+	s_logcur=0;
+	s_logpos=0;
+	s_logpending=0;
+	for(i=0;i<LOGSTAT_NUM;i++) s_logstat[i]=0;
+	s_loghandle=n+1;
+	// CS1 interrupt: priority 1 (see lib_interrupt_main())
+	IPC0bits.CS1IP=1;
+	IPC0bits.CS1IS=0;
+	IEC0bits.CS1IE=1;
+	start_timer1(CPU_CLOCK_HZ/rate);
+}
+
+int logger_info(int info){
+	// Statistics of LOGSTART (see SYSTEM(63)-SYSTEM(66))
+	int ms;
+	switch(info){
+		case 0: // Number of samples
+			return s_logstat[LOGSTAT_SAMPLES];
+		case 1: // Number of dropped samples
+			return s_logstat[LOGSTAT_DROPPED];
+		case 2: // Bytes written
+			return s_logstat[LOGSTAT_BYTES];
+		case 3: // Bytes per second while writing
+			ms=s_logstat[LOGSTAT_USEC]/1000;
+			if (!ms) return 0;
+			return (s_logstat[LOGSTAT_BYTES]/ms)*1000+(s_logstat[LOGSTAT_BYTES]%ms)*1000/ms;
+		default:
+			return 0;
+	}
+}
+
+int lib_logger(int func, int* params, int v0){
+	switch(func){
+		case LOG_START:
+			log_start((char*)params[1],params[2],v0);
+			return v0;
+		case LOG_STOP:
+			log_stop(1);
+			return v0;
+		default:
+			err_unknown();
+			return v0;
+	}
+}
+
+void release_file_buffers(void){
+	// Flush all buffers and forget them, as heap area will be cleared (see lib_clear()).
+	// The buffers will be allocated again when used.
+	// VDIM arrays, files on RAM disk, index of key-value store, and buffers of LOGSTART
+	// will be also cleared, so their files are closed.
+	int n;
+	file_async_wait();
+	kv_close(0);
+	log_stop(0);
+	for(n=0;n<FILE_HANDLE_NUM;n++){
+		if (s_fvdim[n] || (s_fflags[n]&FHANDLE_RAM)) {
+			if (s_fvdim[n]) vdim_close(n);
+			fbuff_close(n);
+		}
+		if (!s_fhandle[n]) continue;
+		fbuff_flush(n);
+		s_fbuff[n]=0;
+	}
+	ramdisk_init();
+}
+
+int file_handle_info(int info, int handle){
+	// Statistics of file handle (see SYSTEM(56)-SYSTEM(60))
+	if (handle<1 || FILE_HANDLE_NUM<handle || info<0 || FSTAT_NUM<=info) return 0;
+	return s_fstat[handle-1][info];
 }
 
 int lib_file(enum functions func, int a0, int a1, int v0){
-	static FSFILE* s_fhandle[2]={0,0};
 	static char activefhandle=0;
 	static int numinline=0;
 	FSFILE* fhandle=0;
 	int i;
-	int buff[1];
+	char buff[1];
 	char* str;
 
 	// Immediately return if file system is invalid.
 	// See also "case LIB_FILE:" in _call_library().
 //	if (!g_fs_valid) return v0;
 
-	if (activefhandle) fhandle=s_fhandle[activefhandle-1];
+	// Background reading is completed before using SD card, or cancelled by FINIT.
+	switch(func){
+		case FUNC_FINIT:
+			s_fasync=0;
+			s_faremain=0;
+			break;
+		case FUNC_FASYNCREMAIN:
+			return file_async_remaining();
+		default:
+			file_async_wait();
+			break;
+	}
+	// Index of current file handle
+	i=activefhandle-1;
+	if (activefhandle) {
+		switch(func){
+			case FUNC_FINIT:
+			case FUNC_FOPEN:
+			case FUNC_FOPENST:
+			case FUNC_FILE:
+			case FUNC_FCLOSE:
+				break;
+			default:
+				// Parked file will be opened again here.
+				fhandle=fbuff_handle(i);
+				break;
+		}
+	}
 	switch(func){
 		case FUNC_FINIT:
 			// This function is not BASIC statement/function but used from
 			// running routine. 
-			for(i=0;i<2;i++){
-				if (s_fhandle[i]) FSfclose(s_fhandle[i]);
+			s_fclosing=1;
+			log_stop(0);
+			for(i=0;i<FILE_HANDLE_NUM;i++){
+				// Write changed pages of VDIM array
+				if (s_fvdim[i]) vdim_close(i);
+				if (s_fhandle[i] && !(s_fflags[i]&FHANDLE_RAM)) {
+					// Write buffered bytes before closing file.
+					// Files on RAM disk are just discarded.
+					fbuff_sync(i);
+					FSfclose(s_fhandle[i]);
+				}
 				s_fhandle[i]=0; 
+				s_fflags[i]=0;
+				s_fbuff[i]=0;
+				s_fbwrite[i]=0;
+				for(a0=0;a0<FSTAT_NUM;a0++) s_fstat[i][a0]=0;
 			}
+			s_fclosing=0;
+			s_kvhandle=0;
+			s_kvmap=0;
+			ramdisk_init();
 			activefhandle=0;
 			numinline=0;
 			break;
@@ -800,74 +2252,50 @@ int lib_file(enum functions func, int a0, int a1, int v0){
 		case FUNC_FOPENST: // Stop with error when called as a statement.
 			activefhandle=0;
 			// Check if file handle is free to use, first.
-			switch(v0){
-				case 0:
-					// File handle was not designated
-					// Force handle=1 and continue to following cases.
-					v0=1;
-				case 1:
-				case 2:
-					// File handle was designated
-					// Check if not used yet.
-					if (s_fhandle[v0-1]) {
-						// This file handle has been occupied.
-						err_file();
-						return 0;
-					}
-					// OK. This file handle can be asigned for new file opened.
-					break;
-				default:
-					err_invalid_param();
-					return 0;
+			// If file handle was not designated, force handle=1.
+			if (v0==0) v0=1;
+			if (v0<0 || FILE_HANDLE_NUM<v0) {
+				err_invalid_param();
+				return 0;
+			}
+			if (s_fflags[v0-1]) {
+				// This file handle has been occupied.
+				err_file();
+				return 0;
 			}
 			// Open a file
-			fhandle=FSfopen ((const char*) a0, (const char*) a1);
-			if (!fhandle) {
+			if (!fbuff_open(v0-1,(const char*) a0, (const char*) a1)) {
 				if (func==FUNC_FOPENST) err_file();
 				return 0;
 			}
 			// The file is succesfully opened. Asign file handle.
-			s_fhandle[v0-1]=fhandle;
 			activefhandle=v0;
 			return v0;
 		case FUNC_FILE:
-			switch(v0){
-				case 1:
-				case 2:
-					if (s_fhandle[v0-1]) {
-						activefhandle=v0;
-						break;
-					}
-				default:
-					err_invalid_param();
-			}
+			if (0<v0 && v0<=FILE_HANDLE_NUM && s_fflags[v0-1]) activefhandle=v0;
+			else err_invalid_param();
 			break;
 		case FUNC_FCLOSE:
-			switch(v0){
-				case 0:
-					break;
-				case 1:
-				case 2:
-					if (s_fhandle[v0-1]) activefhandle=v0;
-					if (activefhandle) fhandle=s_fhandle[activefhandle-1];
-					break;
-				default:
-					err_invalid_param();
-			}
-			if (fhandle) {
-				FSfclose(fhandle);
-				s_fhandle[activefhandle-1]=0;
+			if (v0<0 || FILE_HANDLE_NUM<v0) err_invalid_param();
+			if (v0 && s_fflags[v0-1]) activefhandle=v0;
+			if (activefhandle) {
+				i=activefhandle-1;
+				activefhandle=0;
+				if (s_fvdim[i]) vdim_close(i);
+				if (s_kvhandle==i+1) kv_close(1);
+				else if (s_loghandle==i+1) log_stop(1);
+				else fbuff_close(i);
 			}
 			activefhandle=0;
 			break;	
 		case FUNC_FINPUT:
 			if (fhandle) {
-				// Determine text length if called without parameter
-				if (v0==0) v0=lib_file_textlen(fhandle);
+				// Read a line if called without parameter
+				if (v0==0) return (int)fbuff_gets(i);
 				// Allocate temporary area for string
 				str=alloc_memory((v0+1+3)/4,-1);
 				// Read from SD card
-				v0=FSfread(str,1,v0,fhandle);
+				v0=fbuff_read(i,str,v0);
 				// Null string at the end.
 				str[v0]=0;
 				return (int)str;
@@ -879,7 +2307,7 @@ int lib_file(enum functions func, int a0, int a1, int v0){
 			// Like lib_printstr()
 			for(i=0;((char*)v0)[i];i++);
 			if (fhandle) {
-				if (!FSfwrite((char*)v0,1,i,fhandle)) err_file();
+				if (i) fbuff_write(activefhandle-1,(char*)v0,i);
 			} else err_file();
 			numinline+=i;
 			break;
@@ -901,46 +2329,46 @@ int lib_file(enum functions func, int a0, int a1, int v0){
 			}
 			break;
 		case FUNC_FGET:
-			if (fhandle) return FSfread((void*)a0,1,v0,fhandle);
+			if (fhandle) return fbuff_read(i,(char*)a0,v0);
 			err_file();
 			break;
 		case FUNC_FPUT:
-			if (fhandle) return FSfwrite((void*)a0,1,v0,fhandle);
+			if (fhandle) return fbuff_write(i,(char*)a0,v0);
+			err_file();
+			break;
+		case FUNC_FGETASYNC:
+			if (fhandle) return fasync_start(i,(char*)a0,v0);
 			err_file();
 			break;
 		case FUNC_FGETC:
-			if (fhandle) {
-				// Note: Little endian.
-				if (FSfread((void*)&buff[0],1,1,fhandle)) return buff[0]&0xff;
-				else return -1;
-			}
+			if (fhandle) return fbuff_getc(i);
 			err_file();
 			break;
 		case FUNC_FPUTC:
 			if (fhandle) {
-				// Note: Little endian.
 				buff[0]=v0;
-				return FSfwrite((void*)&buff[0],1,1,fhandle);
+				return fbuff_write(i,&buff[0],1);
 			}
 			err_file();
 			break;
 		case FUNC_FSEEK:
-			if (fhandle) return FSfseek(fhandle,v0,SEEK_SET);
+			if (fhandle) return fbuff_seek(i,v0);
 			err_file();
 			break;
 		case FUNC_FTELL:
-			if (fhandle) return FSftell(fhandle);
+			if (fhandle) return s_fbpos[i]+s_fbptr[i];
 			err_file();
 			break;
 		case FUNC_FLEN:
-			if (fhandle) return fhandle->size;
+			if (fhandle) return fbuff_len(i);
 			err_file();
 			break;
 		case FUNC_FEOF:
-			if (fhandle) return (fhandle->size<=FSftell(fhandle)) ? 1:0;
+			if (fhandle) return (fbuff_len(i)<=s_fbpos[i]+s_fbptr[i]) ? 1:0;
 			err_file();
 			break;
 		case FUNC_FREMOVE:
+			if (ramdisk_file((const char *)v0)) return ramdisk_remove((const char *)v0);
 			return FSremove((const char *)v0);
 		default:
 			err_unknown();
@@ -948,6 +2376,24 @@ int lib_file(enum functions func, int a0, int a1, int v0){
 	return v0;
 }
 
+int lib_file_array(int flags, char* array, int start, int count){
+	// FGET A(),START,COUNT and FPUT A(),START,COUNT
+	// Returns number of elements read or written.
+	int shift;
+	if (flags & FILE_ARRAY32) shift=2;
+	else if (flags & FILE_ARRAY16) shift=1;
+	else shift=0;
+	if (start<0 || count<0) err_invalid_param();
+	if (count==0) return 0;
+	// Region must be within the block of array
+	array+=start<<shift;
+	count<<=shift;
+	if (!withinRAM(array) || !withinRAM(array+count-1)) err_invalid_param();
+	if (!within_heap_block(array,count)) err_invalid_param();
+	// Whole buffers are directly read to/written from array (see fbuff_read() and fbuff_write()).
+	return lib_file((enum functions)(flags & FUNC_MASK),(int)array,0,count)>>shift;
+}
+
 int lib_readkey(){
 	int ret=ps2readkey();
 	return ret|(vkey<<8);
@@ -1039,8 +2485,13 @@ int _call_library(int a0,int a1,int v0,enum libs a3){
 		case LIB_SCROLL:
 			scroll(g_libparams[1],v0);
 			return v0;
+		case LIB_VDIM:
+			IEC0CLR=_IEC0_CS1IE_MASK;
+			return lib_vdim(a3 & ~LIB_MASK,a0,g_libparams,v0);
 		case LIB_FILE:
+			IEC0CLR=_IEC0_CS1IE_MASK;
 //			if (!g_fs_valid) err_str("File System not initialized");
+			if (a3 & FILE_ARRAY) return lib_file_array(a3 & ~LIB_MASK,(char*)g_libparams[1],g_libparams[2],v0);
 			return lib_file((enum functions)(a3 & FUNC_MASK),g_libparams[1],g_libparams[2],v0);
 		case LIB_KEYS:
 			return lib_keys(v0);
@@ -1060,6 +2511,7 @@ int _call_library(int a0,int a1,int v0,enum libs a3){
 			set_music((char*)v0,a0);
 			return v0;
 		case LIB_PLAYWAVE:
+			IEC0CLR=_IEC0_CS1IE_MASK;
 			play_wave((char*)g_libparams[1],v0);
 			return v0;
 		case LIB_PLAYWAVEFUNC:
@@ -1068,12 +2520,28 @@ int _call_library(int a0,int a1,int v0,enum libs a3){
 			drawcount=(v0&0x0000FFFF);
 			return v0;
 		case LIB_GETDIR:
+			IEC0CLR=_IEC0_CS1IE_MASK;
 			return lib_getdir();
 		case LIB_SETDIRFUNC:
 		case LIB_SETDIR:
+			IEC0CLR=_IEC0_CS1IE_MASK;
 			return lib_setdir(a3,(char*)v0);
 		case LIB_DRAWCOUNT:
 			return drawcount;
+		case LIB_SORT:
+			return lib_sort(a3 & ~LIB_MASK,(int*)g_libparams[1],(int*)g_libparams[2],v0);
+		case LIB_MEMORY:
+			IEC0CLR=_IEC0_CS1IE_MASK;
+			return lib_memory(a3 & ~LIB_MASK,(char*)g_libparams[1],g_libparams[2],v0);
+		case LIB_MAP:
+			IEC0CLR=_IEC0_CS1IE_MASK;
+			return lib_map(a3,g_libparams,v0);
+		case LIB_KVSTORE:
+			IEC0CLR=_IEC0_CS1IE_MASK;
+			return lib_kvstore(a3 & ~LIB_MASK,g_libparams,v0);
+		case LIB_LOGGER:
+			IEC0CLR=_IEC0_CS1IE_MASK;
+			return lib_logger(a3 & ~LIB_MASK,g_libparams,v0);
 		case LIB_SYSTEM:
 			return lib_system(a0, a1 ,v0, a3, g_gcolor, g_prev_x, g_prev_y);
 		case LIB_RESTORE:
@@ -1131,7 +2599,7 @@ int _call_library(int a0,int a1,int v0,enum libs a3){
 			lib_clear();
 			return v0;
 		case LIB_DIM:
-			return (int)lib_dim(a0,a1,(int*)v0);
+			return (int)lib_dim(a0,a1,(int*)v0,a3 & ~LIB_MASK);
 #ifdef __DEBUG
 		case LIB_DEBUG:
 			asm volatile("nop");
@@ -226,6 +226,8 @@ void* search_ifout(unsigned int start){
 char* link(void){
 	int pos;
 	unsigned int code1,code2,label;
+	// Hoist loop invariants before resolving loop structures
+	hoist_loop_invariants();
 	g_fileline=0;
 	for(pos=0;pos<g_objpos;pos++){
 		code1=g_object[pos];
@@ -271,19 +273,6 @@ char* link(void){
 				g_object[pos++]=0x00000000; // nop
 				g_object[pos]=code2;
 				break;
-			case 0x0814:
-				// SOUND etc, for setting v0 as pointer to label/line
-				code2=g_object[pos+1];
-				if ((code2&0xFFFF0000)!=0x08150000) continue;
-				code1&=0x0000FFFF;
-				code2&=0x0000FFFF;
-				label=(code1<<16)|code2;
-				code1=(int)search_label(label);
-				g_label=label;
-				if (!code1) return ERR_LABEL_NF;
-				g_object[pos++]=0x3C020000|((code1>>16)&0x0000FFFF); // lui   v0,xxxx
-				g_object[pos]  =0x34420000|(code1&0x0000FFFF);       // ori v0,v0,xxxx
-				break;
 			case 0x0816:
 				switch(code1&0xFFFF) {
 					case 0x0000:
@@ -364,6 +353,42 @@ char* link(void){
 				// Change them to stack increase/decrease commands.
 				g_object[pos]=0x27BD0000|(code1&0x0000FFFF); //// addiu       sp,sp,xx
 				break;
+			default:
+				break;
+		}
+	}
+	// Optimize GOSUB statements
+	optimize_gosub();
+	// Remove unreachable codes
+	eliminate_dead_code();
+	// Resolve pointers to labels
+	return link_pointers();
+}
+
+char* link_pointers(void){
+	// Pointers to label/line must be resolved after removing dead code.
+	int pos;
+	unsigned int code1,code2,label;
+	for(pos=0;pos<g_objpos;pos++){
+		code1=g_object[pos];
+		switch(code1>>16){
+			case 0x0411:
+				// "bgezal zero," assembly found. Skip following block (strig).
+				pos+=code1&0x0000FFFF;
+				break;
+			case 0x0814:
+				// SOUND etc, for setting v0 as pointer to label/line
+				code2=g_object[pos+1];
+				if ((code2&0xFFFF0000)!=0x08150000) continue;
+				code1&=0x0000FFFF;
+				code2&=0x0000FFFF;
+				label=(code1<<16)|code2;
+				code1=(int)search_label(label);
+				g_label=label;
+				if (!code1) return ERR_LABEL_NF;
+				g_object[pos++]=0x3C020000|((code1>>16)&0x0000FFFF); // lui   v0,xxxx
+				g_object[pos]  =0x34420000|(code1&0x0000FFFF);       // ori v0,v0,xxxx
+				break;
 			case 0x2407:                                // addiu       a3,zero,xxxx
 				if (g_object[pos-1]!=0x02E0F809) break; // jalr        ra,s7
 				// call_lib_code(x)
@@ -393,4 +418,956 @@ char* link(void){
 		}
 	}
 	return 0;
-}
\ No newline at end of file
+}
+
+/*
+	Following functions are used for analyzing the linked code.
+	get_jump_target() returns the position of destination of "j" or "jal" at pos.
+	get_branch_target() returns the position of destination of branch at pos.
+	Both return -1 if the code is not jump/branch or the destination is out of current object.
+*/
+
+int get_jump_target(int pos){
+	unsigned int code;
+	code=g_object[pos];
+	if ((code&0xF8000000)!=0x08000000) return -1; // not j/jal
+	code=(((unsigned int)(&g_object[pos]))&0xF0000000)|((code&0x03FFFFFF)<<2);
+	pos=((int*)code)-g_object;
+	if (pos<0 || g_objpos<=pos) return -1;
+	return pos;
+}
+
+int get_branch_target(int pos){
+	unsigned int code;
+	code=g_object[pos];
+	switch(code>>26){
+		case 0x01: // REGIMM
+			switch((code>>16)&0x1F){
+				case 0x00: case 0x01: case 0x02: case 0x03: // bltz, bgez, bltzl, bgezl
+				case 0x10: case 0x11: case 0x12: case 0x13: // bltzal, bgezal, bltzall, bgezall
+					break;
+				default:
+					return -1;
+			}
+			break;
+		case 0x04: case 0x05: case 0x06: case 0x07: // beq, bne, blez, bgtz
+		case 0x14: case 0x15: case 0x16: case 0x17: // beql, bnel, blezl, bgtzl
+			break;
+		default:
+			return -1;
+	}
+	pos+=1+(short)(code&0xFFFF);
+	if (pos<0 || g_objpos<pos) return -1;
+	return pos;
+}
+
+/*
+	Work area for analyzing the linked code.
+	The free area after object is used for bitmap (one bit for each word in object),
+	number of bits before each bitmap word, and stack of positions to explore.
+*/
+
+static unsigned int* g_link_bitmap;
+static int* g_link_count;
+static int* g_link_stack;
+static int g_link_stackmax;
+
+#define link_bit(pos) (g_link_bitmap[(pos)>>5]&(1<<((pos)&31)))
+#define link_set(pos) g_link_bitmap[(pos)>>5]|=1<<((pos)&31)
+
+int link_work_area(void){
+	// Prepare work area and clear bitmap.
+	// Returns non-zero if there isn't enough space.
+	int i,words;
+	words=(g_objpos+32)>>5;
+	if (g_objmax-(g_object+g_objpos)<words*2+256) return 1;
+	g_link_bitmap=(unsigned int*)&g_object[g_objpos];
+	g_link_count=&g_object[g_objpos+words];
+	g_link_stack=&g_object[g_objpos+words*2];
+	g_link_stackmax=g_objmax-(g_object+g_objpos)-words*2;
+	for(i=0;i<words;i++) g_link_bitmap[i]=0;
+	return 0;
+}
+
+void relocate_cmpdata(int* (*newaddr)(int* addr)){
+	// Relocate pointers to codes in cmpdata, when codes are moved.
+	int* record;
+	cmpdata_reset();
+	while(record=cmpdata_find(CMPDATA_FIELD)){
+		if ((record[0]&0xffff)!=CMPTYPE_PUBLIC_METHOD) continue;
+		record[2]=(int)newaddr((int*)record[2]);
+	}
+	cmpdata_reset();
+	while(record=cmpdata_find(CMPDATA_UNSOLVED)){
+		if ((record[0]&0xffff)==CMPTYPE_NEW_FUNCTION) record[2]=(int)newaddr((int*)record[2]);
+		record[3]=(int)newaddr((int*)record[3]);
+	}
+}
+
+int bit_count(unsigned int bits){
+	int i;
+	for(i=0;bits;i++) bits&=bits-1;
+	return i;
+}
+
+/*
+	GOSUB optimization
+	GOSUB statement without argument is compiled to following 16 words:
+		lw          v0,-8(s5)
+		addiu       sp,sp,-16
+		sw          v0,8(sp)
+		sw          s5,12(sp)
+		ori         v0,zero,0
+		sw          v0,16(sp)
+		addiu       s5,sp,16
+		addiu       sp,sp,-4
+		bgezall     zero,label1
+		sw          sp,-12(s5)
+		beq         zero,zero,label2
+		nop
+	label1:
+		j           xxxx
+		sw          ra,4(sp)
+	label2:
+		lw          s5,12(sp)
+		addiu       sp,sp,16
+	These codes will be replaced by one of followings:
+		1) "GOSUB X:RETURN" is replaced by jump to X, if X doesn't use ARGS().
+		2) Small subroutine is embedded (inline expansion), if it fits to these 16 words.
+		3) Arguments stack is not created, if X doesn't use ARGS().
+*/
+
+static const unsigned int g_gosub_code[16]={
+	0x8EA2FFF8, // lw          v0,-8(s5)
+	0x27BDFFF0, // addiu       sp,sp,-16
+	0xAFA20008, // sw          v0,8(sp)
+	0xAFB5000C, // sw          s5,12(sp)
+	0x34020000, // ori         v0,zero,0
+	0xAFA20010, // sw          v0,16(sp)
+	0x27B50010, // addiu       s5,sp,16
+	0x27BDFFFC, // addiu       sp,sp,-4
+	0x04130003, // bgezall     zero,label1
+	0xAEBDFFF4, // sw          sp,-12(s5)
+	0x10000003, // beq         zero,zero,label2
+	0x00000000, // nop
+	0x08000000, // j           xxxx (see get_gosub_target())
+	0xAFBF0004, // sw          ra,4(sp)
+	0x8FB5000C, // lw          s5,12(sp)
+	0x27BD0010  // addiu       sp,sp,16
+};
+
+static const unsigned int g_return_code4[4]={
+	0x8EBDFFF4, // lw          sp,-12(s5)
+	0x8FA30004, // lw          v1,4(sp)
+	0x00600008, // jr          v1
+	0x27BD0004  // addiu       sp,sp,4
+};
+
+int is_return_code(int pos){
+	int i;
+	if (g_objpos<pos+4) return 0;
+	for(i=0;i<4;i++){
+		if (g_object[pos+i]!=g_return_code4[i]) return 0;
+	}
+	return 1;
+}
+
+int get_gosub_target(int pos){
+	// Returns the position of subroutine if GOSUB without argument is at pos.
+	int i;
+	if (g_objpos<pos+16) return -1;
+	for(i=0;i<16;i++){
+		if (i==12) continue;
+		if (g_object[pos+i]!=g_gosub_code[i]) return -1;
+	}
+	return get_jump_target(pos+12);
+}
+
+int sub_uses_args(int start){
+	// Explore the codes of subroutine.
+	// Returns non-zero if ARGS() may be used (or cannot be determined).
+	int pos,sp,target;
+	unsigned int code;
+	if (link_work_area()) return 1;
+	sp=0;
+	g_link_stack[sp++]=start;
+	while(sp){
+		pos=g_link_stack[--sp];
+		while(pos<g_objpos && !link_bit(pos)){
+			link_set(pos);
+			code=g_object[pos];
+			if ((code>>16)==0x0411) {
+				// String/data block
+				pos+=(code&0x0000FFFF)+1;
+				continue;
+			}
+			if ((code>>16)==0x0814 && (g_object[pos+1]>>16)==0x0815) {
+				// Pointer to label (not a jump)
+				pos+=2;
+				continue;
+			}
+			if ((code&0xFFFF8000)==0x8EA20000) return 1; // lw          v0,xx(s5)
+			if (code==0x02A21021) return 1;               // addu        v0,s5,v0
+			if (g_object[pos+1]==0xAFBF0004 && ((code&0xFC000000)==0x08000000 || code==0x00400008)) {
+				// Calling GOSUB or method. See the codes after bgezall for returning.
+				break;
+			}
+			if (code==0x00400008 && ((unsigned int)g_object[pos-1]>>16)!=0x8F82) {
+				// jr v0 is allowed only for END statement: lw v0,xxxx(gp)
+				return 1;
+			}
+			target=get_jump_target(pos);
+			if (target<0) target=get_branch_target(pos);
+			if (0<=target && !link_bit(target)) {
+				if (g_link_stackmax<=sp) return 1;
+				g_link_stack[sp++]=target;
+			} else if (target<0 && (code&0xFC000000)==0x08000000) {
+				// Jump to outside
+				return 1;
+			}
+			if ((code&0xFC000000)==0x08000000 || (code&0xFC00003F)==0x00000008 || (code>>16)==0x1000) {
+				// j, jr, or b: check delay slot and stop here.
+				pos++;
+				if (pos<g_objpos && (g_object[pos]&0xFFFF8000)==0x8EA20000) return 1;
+				break;
+			}
+			pos++;
+		}
+	}
+	return 0;
+}
+
+int unsolved_in_range(int start, int end){
+	// Check if CMPDATA_UNSOLVED points to code in the range.
+	int* record;
+	int* begin=&g_object[start];
+	int* stop=&g_object[end];
+	cmpdata_reset();
+	while(record=cmpdata_find(CMPDATA_UNSOLVED)){
+		if (begin<=(int*)record[2] && (int*)record[2]<stop) return 1;
+		if (begin<=(int*)record[3] && (int*)record[3]<stop) return 1;
+	}
+	return 0;
+}
+
+int sub_inline_length(int start, int* bstart){
+	// Check if the subroutine can be embedded in GOSUB code.
+	// Returns the length of codes without RETURN, or -1 if not possible.
+	int pos,target,tmin,tmax;
+	unsigned int code;
+	// Skip label/line numbers
+	while(start<g_objpos){
+		code=g_object[start];
+		if ((code>>16)==0x3416) {
+			start++;
+		} else if ((code>>16)==0x3C16 && (g_object[start+1]>>16)==0x36D6) {
+			start+=2;
+		} else {
+			break;
+		}
+	}
+	bstart[0]=start;
+	tmin=start;
+	tmax=start;
+	for(pos=start;pos<g_objpos && pos-start<=16;pos++){
+		code=g_object[pos];
+		if (code==0x8EBDFFF4) {
+			// "lw sp,-12(s5)" must be the RETURN statement.
+			if (!is_return_code(pos)) return -1;
+			// All branches must be inside.
+			if (tmin<start || pos<tmax) return -1;
+			if (unsolved_in_range(start,pos)) return -1;
+			return pos-start;
+		}
+		if ((code>>16)==0x0411) {
+			// String block can be embedded, but DATA cannot.
+			if ((g_object[pos+1]&0xFFFFFFFC)==0x00000020) return -1;
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		if ((code>>16)==0x3C16) return -1;            // label
+		if (code==0xAEBDFFF4) return -1;              // sw          sp,-12(s5)
+		if ((code&0xFFFF8000)==0x8EA20000) return -1; // lw          v0,xx(s5)
+		if (code==0x02A21021) return -1;              // addu        v0,s5,v0
+		if ((code&0xF8000000)==0x08000000) return -1; // j, jal
+		if ((code&0xFC00003E)==0x00000008) {
+			// jr, jalr: only calling library is allowed
+			if (code!=0x02E0F809 && code!=0x0100F809) return -1; // jalr ra,s7 / jalr ra,t0
+		}
+		if ((code&0xFC100000)==0x04100000) return -1; // bgezall etc
+		target=get_branch_target(pos);
+		if (target<0) {
+			if ((code>>26)==0x01 || 0x04<=(code>>26) && (code>>26)<=0x07) return -1;
+		} else {
+			if (target<tmin) tmin=target;
+			if (tmax<target) tmax=target;
+		}
+	}
+	return -1;
+}
+
+void optimize_gosub(void){
+	int pos,target,len,bstart,i;
+	for(pos=0;pos<g_objpos;pos++){
+		if ((g_object[pos]>>16)==0x0411) {
+			// "bgezal zero," assembly found. Skip following block (strig).
+			pos+=g_object[pos]&0x0000FFFF;
+			continue;
+		}
+		target=get_gosub_target(pos);
+		if (target<0) continue;
+		// Check "GOSUB X:RETURN"
+		for(i=pos+16;i<g_objpos && (g_object[i]>>16)==0x3416;i++);
+		if (is_return_code(i) && !sub_uses_args(target)) {
+			// Jump to subroutine after restoring sp.
+			// RETURN in the subroutine returns to the caller of current subroutine.
+			g_object[pos]  =0x8EBDFFF4;       // lw          sp,-12(s5)
+			g_object[pos+1]=g_object[pos+12]; // j           xxxx
+			for(i=2;i<16;i++) g_object[pos+i]=0x00000000; // nop
+			pos+=15;
+			continue;
+		}
+		// Check if inline expansion is possible
+		len=sub_inline_length(target,&bstart);
+		if (0<=len) {
+			for(i=0;i<len;i++){
+				g_object[pos+i]=g_object[bstart+i];
+				// Line number will be that of GOSUB statement.
+				if ((g_object[pos+i]>>16)==0x3416) g_object[pos+i]=0x00000000; // nop
+			}
+			if (len<14) {
+				g_object[pos+len]=0x10000000|(15-len); // beq         zero,zero,xxxx
+				len++;
+			}
+			for(i=len;i<16;i++) g_object[pos+i]=0x00000000; // nop
+			pos+=15;
+			continue;
+		}
+		// Check if stack for arguments is needed
+		if (!sub_uses_args(target)) {
+			// -12(s5) is stored in stack and restored after returning.
+			g_object[pos+11]=g_object[pos+12]; // j           xxxx (label1, see below)
+			g_object[pos]   =0x8EA3FFF4;       // lw          v1,-12(s5)
+			g_object[pos+1] =0x27BDFFF8;       // addiu       sp,sp,-8
+			g_object[pos+2] =0xAFA30008;       // sw          v1,8(sp)
+			g_object[pos+3] =0x04130007;       // bgezall     zero,label1
+			g_object[pos+4] =0xAEBDFFF4;       // sw          sp,-12(s5)
+			g_object[pos+5] =0x10000007;       // beq         zero,zero,label2
+			for(i=6;i<11;i++) g_object[pos+i]=0x00000000; // nop
+			                                   // label1:
+			g_object[pos+12]=0xAFBF0004;       // sw          ra,4(sp)
+			                                   // label2:
+			g_object[pos+13]=0x8FA30004;       // lw          v1,4(sp)
+			g_object[pos+14]=0xAEA3FFF4;       // sw          v1,-12(s5)
+			g_object[pos+15]=0x27BD0004;       // addiu       sp,sp,4
+			pos+=15;
+		}
+	}
+}
+
+/*
+	Dead code elimination
+	Reachability of codes is analyzed from following roots:
+		1) Beginning of object (entry point)
+		2) Interrupt-calling regions (see interrupt_statement())
+		3) Methods (CMPDATA_FIELD)
+		4) All labels and line numbers, when GOTO/GOSUB/RESTORE is dynamic
+	DATA blocks, labels used by RESTORE/SOUND etc, and codes that will be
+	resolved later (CMPDATA_UNSOLVED) are also kept.
+	Unreachable codes are removed and the destinations of jump/branch are relocated.
+	In the work area, the bitmap shows kept codes, and the number of kept codes
+	before each bitmap word is stored in g_link_count[].
+*/
+
+int dce_newpos(int pos){
+	// Returns the position after removing dead codes.
+	return g_link_count[pos>>5]+bit_count(g_link_bitmap[pos>>5]&((1<<(pos&31))-1));
+}
+
+int* dce_newaddr(int* addr){
+	int pos=addr-g_object;
+	if (pos<0 || g_objpos<=pos) return addr;
+	return &g_object[dce_newpos(pos)];
+}
+
+void dce_keep(int* addr, int num){
+	int pos=addr-g_object;
+	for(;0<=pos && pos<g_objpos && 0<num;num--) {
+		link_set(pos);
+		pos++;
+	}
+}
+
+int dce_explore(int pos){
+	// Mark reachable codes from pos.
+	// Returns non-zero if stack is full.
+	int sp,target,i;
+	unsigned int code;
+	sp=0;
+	g_link_stack[sp++]=pos;
+	while(sp){
+		pos=g_link_stack[--sp];
+		while(pos<g_objpos && !link_bit(pos)){
+			code=g_object[pos];
+			if ((code>>16)==0x0411) {
+				// String/data block
+				for(target=pos+(code&0x0000FFFF);pos<=target;pos++) link_set(pos);
+				continue;
+			}
+			if ((code>>16)==0x0814 && (g_object[pos+1]>>16)==0x0815) {
+				// Pointer to label (not a jump)
+				link_set(pos);
+				link_set(pos+1);
+				pos+=2;
+				continue;
+			}
+			link_set(pos);
+			// Determine the destination of jump/branch
+			target=get_jump_target(pos);
+			if (target<0) target=get_branch_target(pos);
+			if ((code&0xFFFF0000)==0x10400000) {
+				// beq v0,zero,xxxx after constant (for example, "IF 0 THEN")
+				for(i=pos-1;0<i && (g_object[i]>>16)==0x3000;i--);
+				if (g_object[i]==0x34020000) {
+					// ori v0,zero,0: always jump
+					code=0x10000000;
+				} else if ((g_object[i]>>16)==0x3402) {
+					// ori v0,zero,xxxx: never jump
+					target=-1;
+				}
+			}
+			if (0<=target && !link_bit(target)) {
+				if (g_link_stackmax<=sp) return 1;
+				g_link_stack[sp++]=target;
+			}
+			if ((code&0xFC000000)==0x08000000 || (code&0xFC00003F)==0x00000008 || (code>>16)==0x1000) {
+				// j, jr, or b: delay slot is the last code.
+				if (pos+1<g_objpos) link_set(pos+1);
+				break;
+			}
+			if (code==0x0100F809 && 2<=pos && 
+					(((unsigned int)g_object[pos-2]<<16)|(g_object[pos-1]&0x0000FFFF))==(unsigned int)lib_interrupt) {
+				// Interrupt-calling region begins 2 words after $ra (see lib_interrupt())
+				if (g_link_stackmax<=sp) return 1;
+				g_link_stack[sp++]=pos+4;
+			}
+			pos++;
+		}
+	}
+	return 0;
+}
+
+int dce_mark(void){
+	// Mark all codes to be kept.
+	// Returns non-zero if analysis is not possible.
+	int pos,dynamic;
+	unsigned int code,label;
+	int* record;
+	// Entry point
+	if (dce_explore(0)) return 1;
+	// Methods
+	cmpdata_reset();
+	while(record=cmpdata_find(CMPDATA_FIELD)){
+		if ((record[0]&0xffff)!=CMPTYPE_PUBLIC_METHOD) continue;
+		pos=((int*)record[2])-g_object;
+		if (pos<0 || g_objpos<=pos) continue;
+		if (dce_explore(pos)) return 1;
+	}
+	// Check if dynamic label is used
+	dynamic=0;
+	for(pos=0;pos<g_objpos;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		if (pos<3 || g_object[pos-1]!=0x02E0F809) continue; // jalr        ra,s7
+		if (code==(0x24070000|LIB_LABEL)) dynamic=1;
+		if (code==(0x24070000|LIB_RESTORE)) {
+			if ((g_object[pos-3]>>16)!=0x3C02 || (g_object[pos-2]>>16)!=0x3442) dynamic=1;
+		}
+	}
+	// All labels and line numbers are roots, when dynamic.
+	if (dynamic) {
+		for(pos=0;pos<g_objpos;pos++){
+			code=g_object[pos];
+			if ((code>>16)==0x0411) {
+				pos+=code&0x0000FFFF;
+				continue;
+			}
+			if ((code>>16)==0x3416 || (code>>16)==0x3C16 && (g_object[pos+1]>>16)==0x36D6) {
+				if (dce_explore(pos)) return 1;
+			}
+		}
+	}
+	// Keep DATA blocks and labels used for pointer
+	for(pos=0;pos<g_objpos;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			if ((g_object[pos+1]&0xFFFFFFFC)==0x00000020) {
+				// DATA block. In case of string, following string block is also kept.
+				dce_keep(&g_object[pos],(code&0x0000FFFF)+1);
+				if ((code&0x0000FFFF)==2 && g_object[pos+2]==(int)&g_object[pos+3]) dce_keep(&g_object[pos+3],(g_object[pos+3]&0x0000FFFF)+1);
+			}
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		if ((code>>16)==0x0814 && (g_object[pos+1]>>16)==0x0815) {
+			// SOUND etc
+			label=(code<<16)|(g_object[pos+1]&0x0000FFFF);
+		} else if (code==(0x24070000|LIB_RESTORE) && 3<=pos && g_object[pos-1]==0x02E0F809 &&
+				(g_object[pos-3]>>16)==0x3C02 && (g_object[pos-2]>>16)==0x3442) {
+			// RESTORE
+			label=(g_object[pos-3]<<16)|(g_object[pos-2]&0x0000FFFF);
+		} else {
+			continue;
+		}
+		record=search_label(label);
+		if (record) dce_keep(record,(label&0xFFFF0000) ? 2:1);
+	}
+	// Keep codes that will be resolved later.
+	cmpdata_reset();
+	while(record=cmpdata_find(CMPDATA_UNSOLVED)){
+		if ((record[0]&0xffff)==CMPTYPE_NEW_FUNCTION) dce_keep((int*)record[2],2);
+		dce_keep((int*)record[3],1);
+	}
+	return 0;
+}
+
+void eliminate_dead_code(void){
+	int pos,newpos,words,target,end;
+	unsigned int code;
+	// Prepare work area after object
+	if (link_work_area()) return;
+	words=(g_objpos+32)>>5;
+	// Analyze the reachability
+	if (dce_mark()) return;
+	// Count kept codes
+	newpos=0;
+	for(pos=0;pos<words;pos++){
+		g_link_count[pos]=newpos;
+		newpos+=bit_count(g_link_bitmap[pos]);
+	}
+	// Subtract the end of object (bit for g_objpos is not set)
+	if (newpos==g_objpos) return;
+	// Relocate pointers in cmpdata
+	relocate_cmpdata(dce_newaddr);
+	// Remove dead codes and relocate jump/branch.
+	// Note that new position is always equal or less than current position.
+	end=-1;
+	for(pos=0;pos<g_objpos;pos++){
+		code=g_object[pos];
+		if (end<pos) {
+			// Code (not in string/data block)
+			if ((code>>16)==0x0411) {
+				end=pos+(code&0x0000FFFF);
+				if ((code&0x0000FFFF)==2 && (g_object[pos+1]&0xFFFFFFFC)==0x00000020 && g_object[pos+2]==(int)&g_object[pos+3]) {
+					// Pointer to string in DATA
+					g_object[pos+2]=(int)dce_newaddr((int*)g_object[pos+2]);
+				}
+			} else if ((code>>16)==0x0814 && (g_object[pos+1]>>16)==0x0815) {
+				end=pos+1;
+			} else if (0<=(target=get_jump_target(pos))) {
+				code=(code&0xFC000000)|((((unsigned int)&g_object[dce_newpos(target)])&0x0FFFFFFF)>>2);
+			} else if (0<=(target=get_branch_target(pos))) {
+				code=(code&0xFFFF0000)|((dce_newpos(target)-dce_newpos(pos)-1)&0x0000FFFF);
+			}
+		}
+		if (link_bit(pos)) g_object[dce_newpos(pos)]=code;
+	}
+	// All done. Clear the removed area.
+	g_dead_code_size+=(g_objpos-newpos)*4;
+	for(pos=newpos;pos<g_objpos;pos++) g_object[pos]=0;
+	g_objpos=newpos;
+}
+
+/*
+	Loop-invariant hoisting
+	Array element, A(X), is accessed by "lw v1,xx(s8); addu v1,v1,v0" (see get_dim_value()
+	and let_dim_sub()). When the array variable is not changed in a FOR/WHILE/DO loop, the 
+	base address is loaded to one of $s0-$s4 before the loop, and the codes are replaced by
+	"addu v1,sx,v0".
+	This is done before resolving the GOTO/GOSUB/BREAK codes, so the loops can be determined
+	by 0x082x/0x083x codes. Hoisting is not done when:
+		1) LABEL() is used, or FOR/WHILE/DO structures are not balanced in object,
+		2) a line or label in the loop is used by GOTO/GOSUB from outside of the loop,
+		3) GOSUB, method, or library that may change variables is called in the loop.
+		4) INTERRUPT is used, and the array variable may be changed outside of the loop
+		   (for example, by DIM in interrupt routine), or CLEAR is used.
+	Note that $s0-$s4 are saved in CS1Handler(), so the codes for interrupt can also use them.
+	Work area (after object, with space for inserted codes):
+		stack for the beginning of loops,
+		sorted list of labels used by GOTO/GOSUB,
+		labels in loop, and positions of removed codes.
+*/
+
+#define HOIST_MAX_DEPTH 64
+#define HOIST_MAX_LABELS 64
+#define HOIST_MAX_CODES 128
+
+static int* g_hoist_labels;
+static int g_hoist_labelnum;
+static int* g_hoist_local;
+static int* g_hoist_del;
+static int g_hoist_delnum;
+static int g_hoist_ins;
+static int g_hoist_insnum;
+static int g_hoist_interrupt;
+
+int hoist_newpos(int pos){
+	// Returns new position of code.
+	int i;
+	if (pos<g_hoist_ins) return pos;
+	for(i=0;i<g_hoist_delnum && g_hoist_del[i]<pos;i++);
+	return pos+g_hoist_insnum-i;
+}
+
+int hoist_newtarget(int pos){
+	// Returns new position of destination of jump/branch.
+	// The jump to the beginning of loop must execute inserted codes.
+	if (pos==g_hoist_ins) return pos;
+	return hoist_newpos(pos);
+}
+
+int* hoist_newaddr(int* addr){
+	int pos=addr-g_object;
+	if (pos<0 || g_objpos<=pos) return addr;
+	return &g_object[hoist_newpos(pos)];
+}
+
+int hoist_label_refs(unsigned int label){
+	// Returns the number of GOTO/GOSUB using label.
+	int low,high,mid,num;
+	low=0;
+	high=g_hoist_labelnum;
+	while(low<high){
+		mid=(low+high)>>1;
+		if ((unsigned int)g_hoist_labels[mid]<label) low=mid+1;
+		else high=mid;
+	}
+	for(num=0;low<g_hoist_labelnum && g_hoist_labels[low]==label;low++) num++;
+	return num;
+}
+
+unsigned int hoist_marker_label(int pos){
+	// Returns label of GOTO/GOSUB (0x0810/0x0812) code at pos, or 0 if not.
+	unsigned int code1,code2;
+	code1=g_object[pos];
+	code2=g_object[pos+1];
+	if ((code1>>16)!=0x0810 && (code1>>16)!=0x0812) return 0;
+	if ((code2>>16)!=(code1>>16)+1) return 0;
+	return (code1<<16)|(code2&0x0000FFFF);
+}
+
+int hoist_labels_ok(int start, int end){
+	// Check if labels in the region are used only from the region.
+	int pos,i,num;
+	unsigned int code,label;
+	// List labels in the region with the numbers of GOTO/GOSUB using them.
+	num=0;
+	for(pos=start;pos<=end;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		if ((code>>16)==0x3416) label=code&0x0000FFFF;
+		else if ((code>>16)==0x3C16 && (g_object[pos+1]>>16)==0x36D6) label=(code<<16)|(g_object[pos+1]&0x0000FFFF);
+		else continue;
+		i=hoist_label_refs(label);
+		if (!i) continue;
+		if (HOIST_MAX_LABELS<=num) return 0;
+		g_hoist_local[num*2]=label;
+		g_hoist_local[num*2+1]=i;
+		num++;
+	}
+	if (!num) return 1;
+	// Subtract the GOTO/GOSUB in the region.
+	for(pos=start;pos<=end;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		label=hoist_marker_label(pos);
+		if (!label) continue;
+		for(i=0;i<num;i++){
+			if (g_hoist_local[i*2]==label) g_hoist_local[i*2+1]--;
+		}
+	}
+	// Remaining ones are used from outside.
+	for(i=0;i<num;i++){
+		if (g_hoist_local[i*2+1]) return 0;
+	}
+	return 1;
+}
+
+int hoist_var_ok(int start, int end, int offset){
+	// Check if the variable at offset(s8) may be changed in the region.
+	int pos;
+	unsigned int code;
+	for(pos=start;pos<=end;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		switch(code>>26){
+			case 0x28: case 0x29: case 0x2B: // sb, sh, sw
+			case 0x09:                       // addiu (address of variable)
+				if (((code>>21)&0x1F)==30 && (code&0xFFFC)==offset) return 0;
+				break;
+			default:
+				break;
+		}
+		// Variable number for library (DIM, string etc)
+		switch(code>>16){
+			case 0x2404: case 0x2405: case 0x2406: // addiu a0/a1/a2,zero,xxxx
+				if ((code&0xFFFF)==(offset>>2)) return 0;
+				break;
+			default:
+				break;
+		}
+	}
+	return 1;
+}
+
+int hoist_loop(int start, int end){
+	// Optimize a loop from start (FOR/WHILE/DO) to end (NEXT/WEND/LOOP).
+	// Returns the number of words increased.
+	int ins,pos,i,j,regs,num;
+	int offsets[5],sregs[5];
+	unsigned int code;
+	// Determine the position to insert codes
+	if ((g_object[start]>>16)==0x0820) {
+		// FOR: insert before "bgezall zero,check" (see for_statement())
+		for(ins=start+1;ins<end;ins++){
+			code=g_object[ins];
+			if ((code>>16)==0x0411) {
+				ins+=code&0x0000FFFF;
+				continue;
+			}
+			if (code==0x04130004 && ((unsigned int)g_object[ins+1]>>16)==0x8FC4 && 
+				g_object[ins+2]==g_object[ins+1] && g_object[ins+3]==0x00822021) break;
+		}
+		if (end<=ins) return 0;
+	} else {
+		// WHILE/DO: insert before "bgezall zero,label1"
+		ins=start-1;
+		if (g_object[ins]!=0x04130001) return 0;
+	}
+	// Check the codes in the loop
+	regs=0x1F; // Available $s0-$s4
+	for(pos=ins;pos<=end;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		// GOSUB and method
+		if ((code>>16)==0x0812) return 0;
+		if (code==0xAFBF0004) {                             // sw          ra,4(sp)
+			code=g_object[pos-1];
+			if (code==0x00400008) return 0;                 // jr          v0
+			if ((code&0xFC000000)==0x08000000 && (code>>20)!=0x082 && (code>>20)!=0x083) return 0;
+			continue;
+		}
+		// Library
+		if ((code>>16)==0x2407 && g_object[pos-1]==0x02E0F809) {
+			switch(code&LIB_MASK){
+				case LIB_DIM:
+				case LIB_CLEAR:
+				case LIB_VAR_PUSH:
+				case LIB_VAR_POP:
+				case LIB_DEBUG:
+					return 0;
+				default:
+					break;
+			}
+		}
+		if (code==0x0100F809) {                              // jalr        t0
+			i=(g_object[pos-2]<<16)|(g_object[pos-1]&0x0000FFFF);
+			if (i!=(int)lib_wait && i!=(int)lib_calloc_memory && 
+				i!=(int)lib_obj_field && i!=(int)lib_let_str_field) return 0;
+		}
+		// Registers $s0-$s4 used in the loop (for example, in inner loop)
+		switch(code>>26){
+			case 0x00: // SPECIAL
+				i=(code>>11)&0x1F;
+				if (16<=i && i<=20) regs&=~(1<<(i-16));
+				// Continue to rt
+			default:
+				i=(code>>16)&0x1F;
+				if (16<=i && i<=20) regs&=~(1<<(i-16));
+				break;
+			case 0x01: // REGIMM
+			case 0x02: // j
+			case 0x03: // jal
+				break;
+		}
+	}
+	if (!regs) return 0;
+	if (!hoist_labels_ok(ins,end)) return 0;
+	// Find the array accesses and determine the variables to hoist.
+	num=0;
+	g_hoist_delnum=0;
+	for(pos=ins;pos<=end;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		if ((code&0xFFFF8000)!=0x8FC30000) continue;   // lw          v1,xx(s8)
+		if ((g_object[pos-1]&0xFFFFFF3F)!=0x00021000) continue; // sll     v0,v0,0x0-0x3
+		if (g_object[pos+1]!=0x00621821) continue;     // addu        v1,v1,v0
+		if (HOIST_MAX_CODES<=g_hoist_delnum) break;
+		for(i=0;i<num;i++){
+			if (offsets[i]==(code&0xFFFF)) break;
+		}
+		if (i==num) {
+			// New variable
+			if (!regs) continue;
+			if (!hoist_var_ok(ins,end,code&0xFFFF)) continue;
+			// Interrupt routine may be called anywhere in the loop.
+			if (g_hoist_interrupt && !hoist_var_ok(0,g_objpos-1,code&0xFFFF)) continue;
+			for(j=16;!(regs&(1<<(j-16)));j++);
+			regs&=~(1<<(j-16));
+			offsets[num]=code&0xFFFF;
+			sregs[num]=j;
+			num++;
+		}
+		// Replace "addu v1,v1,v0" by "addu v1,sx,v0" and remove "lw v1,xx(s8)"
+		g_object[pos+1]=0x00021821|(sregs[i]<<21);     // addu        v1,sx,v0
+		g_hoist_del[g_hoist_delnum++]=pos;
+	}
+	if (!num) return 0;
+	g_hoist_ins=ins;
+	g_hoist_insnum=num;
+	// Relocate jump/branch and pointers
+	relocate_cmpdata(hoist_newaddr);
+	for(pos=0;pos<g_objpos;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			if ((code&0x0000FFFF)==2 && (g_object[pos+1]&0xFFFFFFFC)==0x00000020 && g_object[pos+2]==(int)&g_object[pos+3]) {
+				// Pointer to string in DATA
+				g_object[pos+2]=(int)&g_object[hoist_newpos(pos+3)];
+			}
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		// 0x0810xxxx-0x083Fxxxx are not jump (see link())
+		if ((code>>22)==0x20 && (code&0x00300000)) continue;
+		if ((code&0xFFFFF000)==0x3000F000) {
+			// Number of codes for CONTINUE statement (see loop_statement())
+			i=pos+1-(code&0x0FFF);
+			i=hoist_newpos(pos+1)-hoist_newpos(i);
+			g_object[pos]=0x3000F000|i;
+		} else if (0<=(i=get_jump_target(pos))) {
+			g_object[pos]=(code&0xFC000000)|((((unsigned int)&g_object[hoist_newtarget(i)])&0x0FFFFFFF)>>2);
+		} else if (0<=(i=get_branch_target(pos))) {
+			g_object[pos]=(code&0xFFFF0000)|((hoist_newtarget(i)-hoist_newpos(pos)-1)&0x0000FFFF);
+		}
+	}
+	// Remove codes, then insert codes for loading the base addresses.
+	j=ins;
+	for(pos=ins,i=0;pos<g_objpos;pos++){
+		if (i<g_hoist_delnum && g_hoist_del[i]==pos) {
+			i++;
+			continue;
+		}
+		g_object[j++]=g_object[pos];
+	}
+	shift_obj(&g_object[ins],&g_object[ins+num],j-ins);
+	for(i=0;i<num;i++) g_object[ins+i]=0x8FC00000|(sregs[i]<<16)|offsets[i]; // lw          sx,xx(s8)
+	g_objpos=j+num;
+	return num-g_hoist_delnum;
+}
+
+void hoist_loop_invariants(void){
+	int pos,sp,i,loops,clear;
+	unsigned int code,label;
+	int* stack;
+	char types[HOIST_MAX_DEPTH];
+	// Check LABEL(), INTERRUPT, CLEAR, and the balance of loops
+	sp=loops=0;
+	g_hoist_interrupt=clear=0;
+	for(pos=0;pos<g_objpos;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		if (0<pos && code==(0x24070000|LIB_LABEL) && g_object[pos-1]==0x02E0F809) return;
+		if (0<pos && (code>>16)==0x2407 && (code&LIB_MASK)==LIB_CLEAR && g_object[pos-1]==0x02E0F809) clear=1;
+		if (code==0x0100F809 && 2<=pos && 
+				(((unsigned int)g_object[pos-2]<<16)|(g_object[pos-1]&0x0000FFFF))==(unsigned int)lib_interrupt) {
+			g_hoist_interrupt=1;
+		}
+		switch(code>>16){
+			case 0x0820: // FOR
+			case 0x0821: // WHILE
+			case 0x0822: // DO
+				if (HOIST_MAX_DEPTH<=sp) return;
+				types[sp++]=code>>16&0x0F;
+				loops++;
+				break;
+			case 0x0830: // NEXT
+			case 0x0831: // WEND
+			case 0x0832: // LOOP
+				// Structure must be FOR-NEXT, WHILE-WEND, or DO-LOOP
+				if (!sp || types[--sp]!=(code>>16&0x0F)) return;
+				break;
+			default:
+				break;
+		}
+	}
+	if (sp || !loops) return;
+	// CLEAR in interrupt routine releases all the arrays.
+	if (g_hoist_interrupt && clear) return;
+	// Prepare work area. Object may increase up to 4 words for each loop.
+	stack=&g_object[g_objpos+loops*4+8];
+	g_hoist_labels=stack+HOIST_MAX_DEPTH;
+	if (g_objmax<=g_hoist_labels+HOIST_MAX_LABELS*2+HOIST_MAX_CODES+256) return;
+	// List labels used by GOTO/GOSUB, and sort them.
+	g_hoist_labelnum=0;
+	for(pos=0;pos<g_objpos;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		label=hoist_marker_label(pos);
+		if (!label) continue;
+		if (g_objmax<=g_hoist_labels+g_hoist_labelnum+HOIST_MAX_LABELS*2+HOIST_MAX_CODES+256) return;
+		for(i=g_hoist_labelnum;0<i && label<(unsigned int)g_hoist_labels[i-1];i--){
+			g_hoist_labels[i]=g_hoist_labels[i-1];
+		}
+		g_hoist_labels[i]=label;
+		g_hoist_labelnum++;
+		pos++;
+	}
+	g_hoist_local=g_hoist_labels+g_hoist_labelnum;
+	g_hoist_del=g_hoist_local+HOIST_MAX_LABELS*2;
+	// Optimize loops from inner one
+	for(pos=0;pos<g_objpos;pos++){
+		code=g_object[pos];
+		if ((code>>16)==0x0411) {
+			pos+=code&0x0000FFFF;
+			continue;
+		}
+		switch(code>>16){
+			case 0x0820: // FOR
+			case 0x0821: // WHILE
+			case 0x0822: // DO
+				stack[sp++]=pos;
+				break;
+			case 0x0830: // NEXT
+			case 0x0831: // WEND
+			case 0x0832: // LOOP
+				pos+=hoist_loop(stack[--sp],pos);
+				break;
+			default:
+				break;
+		}
+	}
+}
@@ -0,0 +1,371 @@
+/*
+   This file is provided under the LGPL license ver 2.1.
+   Written by Katsumi.
+   http://hp.vector.co.jp/authors/VA016157/
+   kmorimatsu@users.sourceforge.jp
+*/
+
+/*
+	This file is shared by Megalopa and Zoea
+*/
+
+#include "compiler.h"
+
+/*
+	Map (associative array) structure:
+		map[0]: pointer to lib_map() as signature (see also lib_delete())
+		map[1]: number of entries
+		map[2]: pointer to hash table
+		map[3]: number of slots in hash table (power of 2)
+		map[4]: number of used slots (entries and deleted ones) in hash table
+		map[5]: pointer to old hash table while rehashing, or 0
+		map[6]: number of slots in old hash table
+		map[7]: position of rehashing in old hash table
+
+	Slot structure of hash table:
+		slot[0]: hash and type of key:
+		           0:         empty
+		           1:         deleted
+		           bit 1 set: used (bit 0: string key)
+		slot[1]: key (integer or pointer to string)
+		slot[2]: value
+
+	All blocks (map, hash tables and string keys) are permanent blocks.
+	Hash table is extended when 3/4 of slots are used. The entries of old table
+	are moved to new one step by step in each MAPSET/MAPGET/MAPDEL/MAPHAS, so
+	that large map doesn't cause a long pause.
+*/
+
+#define MAP_SIZE 8
+#define MAP_MIN_SLOTS 8
+#define MAP_REHASH_STEP 8
+
+#define SLOT_EMPTY   0
+#define SLOT_DELETED 1
+#define SLOT_USED    2
+#define SLOT_STRKEY  1
+
+/*
+	Compiler part follows
+*/
+
+static char* get_map_key(int* flags){
+	// Key is string or integer. Result will be in $v0.
+	char* err;
+	err=get_stringFloatOrValue();
+	if (err) return err;
+	switch(g_lastvar){
+		case VAR_INTEGER:
+			*flags=0;
+			return 0;
+		case VAR_STRING:
+			*flags=MAP_STRKEY;
+			return 0;
+		default:
+			return ERR_SYNTAX;
+	}
+}
+
+static char* map_key_params(int func){
+	// X,KEY
+	char* err;
+	int flags;
+	// Get map
+	err=get_value();
+	if (err) return err;
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(2);
+	g_object[g_objpos++]=0x27BDFFFC; // addiu       sp,sp,-4
+	g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
+	// Get key
+	err=get_map_key(&flags);
+	if (err) return err;
+	call_lib_code(LIB_MAP | func | flags);
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BD0004; // addiu       sp,sp,4
+	return 0;
+}
+
+char* mapnew_function(){
+	// MAPNEW()
+	call_lib_code(LIB_MAP | MAP_NEW);
+	return 0;
+}
+
+char* mapset_statement(){
+	// MAPSET X,KEY,VALUE
+	char* err;
+	int flags;
+	// Get map
+	err=get_value();
+	if (err) return err;
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(2);
+	g_object[g_objpos++]=0x27BDFFF8; // addiu       sp,sp,-8
+	g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
+	// Get key
+	err=get_map_key(&flags);
+	if (err) return err;
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(1);
+	g_object[g_objpos++]=0xAFA20008; // sw          v0,8(sp)
+	// Get value
+	err=get_value();
+	if (err) return err;
+	call_lib_code(LIB_MAP | MAP_SET | flags);
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BD0008; // addiu       sp,sp,8
+	return 0;
+}
+
+char* mapget_function(){
+	// MAPGET(X,KEY)
+	return map_key_params(MAP_GET);
+}
+
+char* maphas_function(){
+	// MAPHAS(X,KEY)
+	return map_key_params(MAP_HAS);
+}
+
+char* mapdel_statement(){
+	// MAPDEL X,KEY
+	return map_key_params(MAP_DEL);
+}
+
+/*
+	Library part follows
+*/
+
+static unsigned int map_hash(int key, int flags){
+	// Returns hash of key with type of key in lower 2 bits
+	unsigned int hash;
+	char* str;
+	if (flags & MAP_STRKEY) {
+		// FNV-1a
+		hash=2166136261;
+		for(str=(char*)key;str[0];str++){
+			hash^=(unsigned char)str[0];
+			hash*=16777619;
+		}
+		return (hash&0xFFFFFFFC)|SLOT_USED|SLOT_STRKEY;
+	} else {
+		hash=(unsigned int)key*2654435761;
+		return (hash&0xFFFFFFFC)|SLOT_USED;
+	}
+}
+
+static int map_key_equal(int* slot, unsigned int hash, int key){
+	char* str1;
+	char* str2;
+	if (slot[0]!=hash) return 0;
+	if (!(hash & SLOT_STRKEY)) return slot[1]==key;
+	str1=(char*)slot[1];
+	str2=(char*)key;
+	while(str1[0]==str2[0]){
+		if (!str1[0]) return 1;
+		str1++;
+		str2++;
+	}
+	return 0;
+}
+
+static int* map_search_table(int* table, int num, unsigned int hash, int key){
+	// Returns pointer to slot containing key, or 0 if not found.
+	int i;
+	int* slot;
+	if (!table) return 0;
+	i=(hash>>2)^(hash>>17);
+	while(1){
+		slot=&table[(i&(num-1))*3];
+		if (slot[0]==SLOT_EMPTY) return 0;
+		if (map_key_equal(slot,hash,key)) return slot;
+		i++;
+	}
+}
+
+static int* map_search(int* map, unsigned int hash, int key){
+	// Search both current and old hash table
+	int* slot;
+	slot=map_search_table((int*)map[2],map[3],hash,key);
+	if (slot) return slot;
+	return map_search_table((int*)map[5],map[6],hash,key);
+}
+
+static void map_insert(int* map, unsigned int hash, int key, int value){
+	// Insert key to current hash table.
+	// Key must not exist in map.
+	int i;
+	int* table=(int*)map[2];
+	int* slot;
+	i=(hash>>2)^(hash>>17);
+	while(1){
+		slot=&table[(i&(map[3]-1))*3];
+		if (slot[0]==SLOT_EMPTY) {
+			map[4]++;
+			break;
+		}
+		if (slot[0]==SLOT_DELETED) break;
+		i++;
+	}
+	slot[0]=hash;
+	slot[1]=key;
+	slot[2]=value;
+}
+
+static void map_rehash_step(int* map){
+	// Move some entries from old hash table to current one
+	int i;
+	int* old=(int*)map[5];
+	int* slot;
+	if (!old) return;
+	for(i=0;i<MAP_REHASH_STEP && map[7]<map[6];i++){
+		slot=&old[(map[7]++)*3];
+		if (slot[0]&SLOT_USED) {
+			map_insert(map,slot[0],slot[1],slot[2]);
+			// Old slot is marked as deleted, but not empty, for searching old table.
+			slot[0]=SLOT_DELETED;
+		}
+	}
+	if (map[6]<=map[7]) {
+		// All done. Delete old table.
+		free_perm_str((char*)old);
+		map[5]=0;
+	}
+}
+
+static void map_start_rehash(int* map){
+	// Allocate new hash table. The entries will be moved by map_rehash_step().
+	// When there are many deleted slots, the size of table isn't changed.
+	int i,num;
+	int* table;
+	num=map[3];
+	if (num<=map[1]*2) num*=2;
+	table=alloc_perm_memory(num*3);
+	for(i=0;i<num*3;i++){
+		table[i]=0;
+	}
+	map[5]=map[2];
+	map[6]=map[3];
+	map[7]=0;
+	map[2]=(int)table;
+	map[3]=num;
+	map[4]=0;
+}
+
+static char* map_copy_key(char* str){
+	// Copy string key to a permanent block
+	int i;
+	char* ret;
+	for(i=0;str[i];i++);
+	ret=(char*)alloc_perm_memory((i+4)>>2);
+	for(i=0;ret[i]=str[i];i++);
+	return ret;
+}
+
+static int* map_new(void){
+	int i;
+	int* map;
+	int* table;
+	map=alloc_perm_memory(MAP_SIZE);
+	table=alloc_perm_memory(MAP_MIN_SLOTS*3);
+	for(i=0;i<MAP_MIN_SLOTS*3;i++){
+		table[i]=0;
+	}
+	map[0]=(int)lib_map;
+	map[1]=0;
+	map[2]=(int)table;
+	map[3]=MAP_MIN_SLOTS;
+	map[4]=0;
+	map[5]=0;
+	map[6]=0;
+	map[7]=0;
+	return map;
+}
+
+static void map_free_table(int* table, int num){
+	// Delete string keys and table
+	int i;
+	if (!table) return;
+	for(i=0;i<num;i++){
+		if ((table[i*3]&(SLOT_USED|SLOT_STRKEY))==(SLOT_USED|SLOT_STRKEY)) {
+			free_perm_str((char*)table[i*3+1]);
+		}
+	}
+	free_perm_str((char*)table);
+}
+
+void map_delete(int* map){
+	// Delete map (see lib_delete())
+	map_free_table((int*)map[2],map[3]);
+	map_free_table((int*)map[5],map[6]);
+	map[0]=0;
+	free_perm_str((char*)map);
+}
+
+static void map_foreach_table(int* table, int num, void (*func)(int key, int value)){
+	int i;
+	if (!table) return;
+	for(i=0;i<num;i++){
+		if (table[i*3]&SLOT_USED) func(table[i*3+1],table[i*3+2]);
+	}
+}
+
+void map_foreach(int* map, void (*func)(int key, int value)){
+	// Call func for all entries in map (see kv_compact() in library.c)
+	map_foreach_table((int*)map[2],map[3],func);
+	map_foreach_table((int*)map[5],map[6],func);
+}
+
+int lib_map(int flags, int* params, int v0){
+	int* map;
+	int* slot;
+	int key;
+	unsigned int hash;
+	if ((flags & MAP_FUNC_MASK)==MAP_NEW) return (int)map_new();
+	// Check map
+	map=(int*)params[1];
+	if (!map || map[0]!=(int)lib_map) {
+		err_invalid_param();
+		return 0;
+	}
+	// Move some entries if rehashing
+	map_rehash_step(map);
+	// Search key
+	key=((flags & MAP_FUNC_MASK)==MAP_SET) ? params[2] : v0;
+	hash=map_hash(key,flags);
+	slot=map_search(map,hash,key);
+	switch(flags & MAP_FUNC_MASK){
+		case MAP_SET:
+			if (slot) {
+				slot[2]=v0;
+				return v0;
+			}
+			// Extend hash table if required
+			if (!map[5] && map[3]*3<=(map[4]+1)*4) {
+				map_start_rehash(map);
+				map_rehash_step(map);
+			}
+			// Insert new key
+			if (flags & MAP_STRKEY) key=(int)map_copy_key((char*)key);
+			map_insert(map,hash,key,v0);
+			map[1]++;
+			return v0;
+		case MAP_GET:
+			return slot ? slot[2]:0;
+		case MAP_HAS:
+			return slot ? 1:0;
+		case MAP_DEL:
+			if (!slot) return 0;
+			if (flags & MAP_STRKEY) free_perm_str((char*)slot[1]);
+			slot[0]=SLOT_DELETED;
+			map[1]--;
+			return 0;
+		default:
+			err_unknown();
+			return 0;
+	}
+}
@@ -20,19 +20,46 @@
 	                  This # includes the ones for ALLOC_VAR_NUM, ALLOC_PCG_BLOCK etc, ALLOC_LNV_BLOCK,
 	                  ALLOC_PERM_BLOCK.
 	                  After ALLOC_VAR_NUM area, dedicated memory area and permanent area follows.
-	ALLOC_PERM_BLOCK: Start # of permanent blocks.
-                      The blocks after this number is permanently stored.
-                      Therefore, it must be released when it's not used any more.
+	ALLOC_PERM_BLOCK: Block # for the table of permanent blocks.
+	                  Permanent blocks (objects, string fields etc) are not assigned to
+	                  variables, but registered in this table. Therefore, it must be released
+	                  when it's not used any more.
+	                  The table is placed in heap area and grows when required. Therefore, the
+	                  number of permanent blocks is restricted only by the size of heap area.
+	                  Each word of table contains pointer (upper 16 bits) and size (lower
+	                  16 bits) of a permanent block.
 */
 
-static int g_temp_var_num_candidate=ALLOC_PERM_BLOCK;
+#define g_perm_table ((int*)g_var_mem[ALLOC_PERM_BLOCK])
+#define PERM_TABLE_MIN_SIZE 16
+static int g_perm_num;
 
 #define DELETE_LIST_SIZE 10
 static int g_deleted_num;
 static int g_deleted_pointer[DELETE_LIST_SIZE];
 static int g_deleted_size[DELETE_LIST_SIZE];
 
+/*
+	Object pools:
+	An object deleted by DELETE statement is not released, but kept in the free list
+	of its class. NEW function takes the object from this list if available.
+	Pooled objects are still registered in the table of permanent blocks. The first
+	word of pooled object (pointer to class structure) is used as the link to the next
+	pooled object. All pooled objects are released when memory cannot be allocated.
+	OBJ_POOL_NUM is the maximum number of classes using object pool.
+*/
+#define OBJ_POOL_NUM 16
+static int g_pool_num;
+static int* g_pool_class[OBJ_POOL_NUM];
+static int* g_pool_head[OBJ_POOL_NUM];
+static int g_pool_live[OBJ_POOL_NUM];
+static int g_pool_free[OBJ_POOL_NUM];
+static int g_pool_hits;
+static int g_pool_misses;
+
 static void* alloc_memory_s6(int size, int var_num);
+static int find_free_block(int size, int use_deleted);
+static int release_obj_pools(void);
 
 static void register_deleted_block(int pointer, int size){
 	// There is maximum
@@ -55,6 +82,24 @@ void set_free_area(void* begin, void* end){
 	g_heap_mem=(int*)begin;
 	g_max_mem=(int)((end-begin)/4);
 	g_deleted_num=0;
+	g_perm_num=0;
+	g_pool_num=0;
+	g_pool_hits=0;
+	g_pool_misses=0;
+}
+
+static int get_block(int i, int* pointer){
+	// Returns the size of block and set the pointer.
+	// i<ALLOC_BLOCK_NUM: block assigned to variable
+	// ALLOC_BLOCK_NUM<=i: permanent block
+	int code;
+	if (i<ALLOC_BLOCK_NUM) {
+		pointer[0]=g_var_pointer[i];
+		return g_var_size[i];
+	}
+	code=g_perm_table[i-ALLOC_BLOCK_NUM];
+	pointer[0]=((unsigned int)code)>>16;
+	return code&0xffff;
 }
 
 void* calloc_memory(int size, int var_num){
@@ -106,7 +151,7 @@ static void* alloc_memory_s6(int size, int var_num){
 	asm volatile("b _alloc_memory_main");
 }
 void* _alloc_memory_main(int size, int var_num){
-	int i,j,candidate;
+	int i;
 	// Assign temp var number
 	if (var_num<0) {
 		// Use ALLOC_VAR_NUM here but not ALLOC_BLOCK_NUM
@@ -124,10 +169,23 @@ void* _alloc_memory_main(int size, int var_num){
 	// Clear var to be assigned.
 	g_var_size[var_num]=0;
 	g_var_pointer[var_num]=0;
+	// Try the block previously deleted, not for temporary block.
+	i=find_free_block(size,var_num<26 || ALLOC_VAR_NUM<=var_num);
+	// Available block found.
+	g_var_pointer[var_num]=i;
+	g_var_size[var_num]=size;
+	g_var_mem[var_num]=(int)(&(g_heap_mem[i]));
+	return (void*)g_var_mem[var_num];
+}
+
+static int find_free_block(int size, int use_deleted){
+	int i,j,candidate,pointer,bsize,num;
 	while(1){
-		// Try the block previously deleted, not for temporary block.
+		// Number of all blocks including permanent ones
+		num=ALLOC_BLOCK_NUM+g_perm_num;
+		// Try the block previously deleted.
 		// This is for fast allocation of memory for class object.
-		if (var_num<26 || ALLOC_VAR_NUM<=var_num) {
+		if (use_deleted) {
 			candidate=0;
 			while(g_deleted_num){
 				// Check if the last deleted block fits
@@ -145,10 +203,11 @@ void* _alloc_memory_main(int size, int var_num){
 		}
 		// Try the block after last block
 		candidate=0;
-		for(i=0;i<ALLOC_BLOCK_NUM;i++){
-			if (g_var_size[i]==0) continue;
-			if (candidate<=g_var_pointer[i]) {
-				candidate=g_var_pointer[i]+g_var_size[i];
+		for(i=0;i<num;i++){
+			bsize=get_block(i,&pointer);
+			if (bsize==0) continue;
+			if (candidate<=pointer) {
+				candidate=pointer+bsize;
 			}
 		}
 		if (candidate+size<=g_max_mem) {
@@ -175,15 +234,20 @@ void* _alloc_memory_main(int size, int var_num){
 		// Peviously deleted blocks cannot be used any more
 		g_deleted_num=0;
 		// Check between blocks
-		// Note that there is at least one block with zero pointer and zero size (see above).
-		for(i=0;i<ALLOC_BLOCK_NUM;i++){
-			// Candidate is after this block.
-			candidate=g_var_pointer[i]+g_var_size[i];
+		for(i=-1;i<num;i++){
+			// Candidate is after this block (or at the beginning of heap area).
+			if (i<0) {
+				candidate=0;
+			} else {
+				bsize=get_block(i,&pointer);
+				candidate=pointer+bsize;
+			}
 			// Check if there is an overlap.
-			for(j=0;j<ALLOC_BLOCK_NUM;j++){
-				if (g_var_size[j]==0) continue;
-				if (candidate+size<=g_var_pointer[j]) continue;
-				if (g_var_pointer[j]+g_var_size[j]<=candidate) continue;
+			for(j=0;j<num;j++){
+				bsize=get_block(j,&pointer);
+				if (bsize==0) continue;
+				if (candidate+size<=pointer) continue;
+				if (pointer+bsize<=candidate) continue;
 				// This block overlaps with the candidate
 				candidate=-1;
 				break;
@@ -196,15 +260,13 @@ void* _alloc_memory_main(int size, int var_num){
 			}
 		}
 		if (0<=candidate) break;
+		// Release pooled objects and try again
+		if (release_obj_pools()) continue;
 		// New memory block cannot be allocated.
 		err_no_mem();
 		return 0;
 	}
-	// Available block found.
-	g_var_pointer[var_num]=candidate;
-	g_var_size[var_num]=size;
-	g_var_mem[var_num]=(int)(&(g_heap_mem[candidate]));
-	return (void*)g_var_mem[var_num];
+	return candidate;
 }
 
 void free_temp_str(char* str){
@@ -228,6 +290,56 @@ void free_temp_str(char* str){
 	IEC0SET=ei;
 }
 
+static void expand_perm_table(void){
+	// Allocate larger table of permanent blocks.
+	// Interrupt must be disabled before calling this function.
+	int i,num;
+	int* table;
+	num=g_var_size[ALLOC_PERM_BLOCK];
+	num=num ? num*2 : PERM_TABLE_MIN_SIZE;
+	// Allocate new table as a temporary block, and copy
+	table=(int*)_alloc_memory_main(num,-1);
+	for(i=0;i<g_perm_num;i++){
+		table[i]=g_perm_table[i];
+	}
+	// Release old table
+	if (g_var_size[ALLOC_PERM_BLOCK]) {
+		register_deleted_block(g_var_pointer[ALLOC_PERM_BLOCK],g_var_size[ALLOC_PERM_BLOCK]);
+	}
+	// Move new table from temporary block
+	for(i=26;i<ALLOC_VAR_NUM;i++){
+		if (g_var_size[i] && g_var_mem[i]==(int)table) break;
+	}
+	g_var_pointer[ALLOC_PERM_BLOCK]=g_var_pointer[i];
+	g_var_size[ALLOC_PERM_BLOCK]=num;
+	g_var_mem[ALLOC_PERM_BLOCK]=(int)table;
+	g_var_size[i]=0;
+}
+
+static void add_perm_block(int pointer, int size){
+	// Register a block to the table of permanent blocks.
+	// Interrupt must be disabled before calling this function.
+	if (g_var_size[ALLOC_PERM_BLOCK]<=g_perm_num) expand_perm_table();
+	g_perm_table[g_perm_num++]=(pointer<<16)|size;
+}
+
+static int search_perm_block(int pointer){
+	// Returns the index of permanent block in table, or -1 if not found.
+	// Search from the last one, as it's likely used soon after registered.
+	int i;
+	for(i=g_perm_num-1;0<=i;i--){
+		if ((((unsigned int)g_perm_table[i])>>16)==pointer) break;
+	}
+	return i;
+}
+
+static void delete_perm_block(int i){
+	// Delete a block from the table of permanent blocks.
+	// The last block in table is moved to the position.
+	register_deleted_block(((unsigned int)g_perm_table[i])>>16,g_perm_table[i]&0xffff);
+	g_perm_table[i]=g_perm_table[--g_perm_num];
+}
+
 void free_non_temp_str(char* str){
 	int i,pointer,ei;
 	if (!str) return;
@@ -246,16 +358,18 @@ void free_non_temp_str(char* str){
 			}
 		}
 	}
-	for(i=ALLOC_VAR_NUM;i<ALLOC_BLOCK_NUM;i++){
+	for(i=ALLOC_VAR_NUM;i<ALLOC_PERM_BLOCK;i++){
 		if (g_var_pointer[i]==pointer) {
 			if (g_var_size[i] && g_var_mem[i]==(int)str) {
 				register_deleted_block(pointer,g_var_size[i]);
 				g_var_size[i]=0;
 				g_var_mem[i]=0;
-				if (ALLOC_PERM_BLOCK<=i) g_temp_var_num_candidate=i;
 			}
 		}
 	}
+	// Permanent block
+	i=search_perm_block(pointer);
+	if (0<=i) delete_perm_block(i);
 	// Enable interrupt
 	IEC0SET=ei;
 }
@@ -269,32 +383,47 @@ void free_perm_str(char* str){
 	ei=IEC0&_IEC0_CS1IE_MASK;
 	IEC0CLR=_IEC0_CS1IE_MASK;
 	// Search permanent block and delete a block if found.
-	for(i=ALLOC_PERM_BLOCK;i<ALLOC_BLOCK_NUM;i++){
-		if (g_var_pointer[i]==pointer) {
-			if (g_var_size[i] && g_var_mem[i]==(int)str) {
-				register_deleted_block(pointer,g_var_size[i]);
-				g_var_size[i]=0;
-				g_temp_var_num_candidate=i;
-				break;
-			}
-		}
+	i=search_perm_block(pointer);
+	if (0<=i) delete_perm_block(i);
+	// Enable interrupt
+	IEC0SET=ei;
+}
+
+void let_perm_str(char* str){
+	// Register the region of string as a permanent block (see lib_let_str()).
+	int begin,end,ei;
+	// Determine size
+	for(end=0;str[end];end++);
+	// Check if str is in heap area.
+	begin=(int)str;
+	end=(int)(&str[end]);
+	if (begin<(int)(&g_heap_mem[0]) || (int)(&g_heap_mem[g_max_mem])<=end) {
+		// String is not within allcated block
+		return;
 	}
+	begin=(begin-(int)(&g_heap_mem[0]))>>2;
+	end=(end-(int)(&g_heap_mem[0]))>>2;
+	// Disable interrupt
+	ei=IEC0&_IEC0_CS1IE_MASK;
+	IEC0CLR=_IEC0_CS1IE_MASK;
+	// Register
+	add_perm_block(begin,end-begin+1);
 	// Enable interrupt
 	IEC0SET=ei;
 }
 
 void move_to_perm_block(int var_num){
-	int i;
-	// Find available permanent block
-	i=get_permanent_var_num();
-	// Available block found.
-	// Copy value from variable.
-	g_var_size[i]=g_var_size[var_num];
-	g_var_pointer[i]=g_var_pointer[var_num];
-	g_var_mem[i]=g_var_mem[var_num];
+	int ei;
+	// Disable interrupt
+	ei=IEC0&_IEC0_CS1IE_MASK;
+	IEC0CLR=_IEC0_CS1IE_MASK;
+	// Register the block of variable as a permanent block
+	add_perm_block(g_var_pointer[var_num],g_var_size[var_num]);
 	// Clear variable
 	g_var_size[var_num]=0;
 	g_var_mem[var_num]=0;
+	// Enable interrupt
+	IEC0SET=ei;
 }
 
 int move_from_perm_block_if_exists(int var_num){
@@ -305,21 +434,18 @@ int move_from_perm_block_if_exists(int var_num){
 	ei=IEC0&_IEC0_CS1IE_MASK;
 	IEC0CLR=_IEC0_CS1IE_MASK;
 	// Find stored block
-	for (i=ALLOC_PERM_BLOCK;i<ALLOC_BLOCK_NUM;i++){
-		if (0<g_var_size[i] && g_var_pointer[i]==pointer) break;
-	}
-	if (ALLOC_BLOCK_NUM<=i) {
+	i=search_perm_block(pointer);
+	if (i<0) {
 		// Enable interrupt
 		IEC0SET=ei;
 		return 0; // Not found
 	}
 	// Stored block found.
 	// Replace pointer
-	g_var_size[var_num]=g_var_size[i];
-	g_var_pointer[var_num]=g_var_pointer[i];
-	// Clear block
-	g_var_size[i]=0;
-	g_temp_var_num_candidate=i;
+	g_var_size[var_num]=g_perm_table[i]&0xffff;
+	g_var_pointer[var_num]=pointer;
+	// Delete from table
+	g_perm_table[i]=g_perm_table[--g_perm_num];
 	// Enable interrupt
 	IEC0SET=ei;
 	return 1;
@@ -330,35 +456,19 @@ void move_from_perm_block(int var_num){
 	err_unknown(); // Not found
 }
 
-int get_permanent_var_num(){
+void* alloc_perm_memory(int size){
+	// Allocate memory as a permanent block
 	int i,ei;
 	// Disable interrupt
 	ei=IEC0&_IEC0_CS1IE_MASK;
 	IEC0CLR=_IEC0_CS1IE_MASK;
-	// Try candidate first
-	if (!g_var_size[g_temp_var_num_candidate]) {
-		if (ALLOC_PERM_BLOCK<g_temp_var_num_candidate && 
-				g_temp_var_num_candidate<ALLOC_BLOCK_NUM) {
-			// Reserve
-			g_var_size[g_temp_var_num_candidate]=1;
-			// Enable interrupt
-			IEC0SET=ei;
-			return g_temp_var_num_candidate++;
-		}
-	}
-	// Candidate is not available. Seek all.
-	for (i=ALLOC_PERM_BLOCK;i<ALLOC_BLOCK_NUM;i++) {
-		if (g_var_size[i]==0) {
-			g_temp_var_num_candidate=i+1;
-			// Reserve
-			g_var_size[i]=1;
-			// Enable interrupt
-			IEC0SET=ei;
-			return i;
-		}
-	}
-	err_no_block();
-	return 0;
+	// Prepare table before allocating memory
+	if (g_var_size[ALLOC_PERM_BLOCK]<=g_perm_num) expand_perm_table();
+	i=find_free_block(size,1);
+	add_perm_block(i,size);
+	// Enable interrupt
+	IEC0SET=ei;
+	return (void*)(&g_heap_mem[i]);
 }
 
 int get_varnum_from_address(void* address){
@@ -370,12 +480,154 @@ int get_varnum_from_address(void* address){
 	return -1;
 }
 
-void* lib_calloc_memory(int size){
-	// Allocate memory and return address
-	return calloc_memory(size,get_permanent_var_num());
+static int search_obj_pool(int* classdata){
+	// Returns the index of object pool for the class, or -1 if not found.
+	int i;
+	for(i=0;i<g_pool_num;i++){
+		if (g_pool_class[i]==classdata) return i;
+	}
+	return -1;
+}
+
+static int in_obj_pool(int* object, int size){
+	// Check if the object is already in pool.
+	int i;
+	int* pooled;
+	for(i=0;i<g_pool_num;i++){
+		if (object_size(g_pool_class[i])!=size) continue;
+		for(pooled=g_pool_head[i];pooled;pooled=(int*)pooled[0]){
+			if (pooled==object) return 1;
+		}
+	}
+	return 0;
+}
+
+static int release_obj_pools(void){
+	// Release all pooled objects.
+	// Returns non-zero if any object is released.
+	// Interrupt must be disabled before calling this function.
+	int i,j,ret;
+	int* pooled;
+	ret=0;
+	for(i=0;i<g_pool_num;i++){
+		for(pooled=g_pool_head[i];pooled;pooled=(int*)pooled[0]){
+			j=search_perm_block(((int)pooled-(int)g_heap_mem)>>2);
+			if (0<=j) delete_perm_block(j);
+			ret=1;
+		}
+		g_pool_head[i]=0;
+		g_pool_free[i]=0;
+	}
+	return ret;
+}
+
+int object_pool_info(int info, int index){
+	// Statistics of object pools (see SYSTEM(50)-SYSTEM(55))
+	switch(info){
+		case 0: return g_pool_hits;
+		case 1: return g_pool_misses;
+		case 2: return g_pool_num;
+		default: break;
+	}
+	if (index<0 || g_pool_num<=index) return 0;
+	switch(info){
+		case 3: return g_pool_live[index];
+		case 4: return g_pool_free[index];
+		case 5: return (int)g_pool_class[index];
+		default: return 0;
+	}
+}
+
+int within_heap_block(void* address, int len){
+	// Check if the region is within a block allocated in heap area.
+	// Returns 1 if within a block or outside heap area, or 0 if not.
+	int i,num,begin,pointer,size;
+	begin=(int)address-(int)g_heap_mem;
+	if (begin<0 || (g_max_mem<<2)<=begin) return 1;
+	num=ALLOC_BLOCK_NUM+g_perm_num;
+	for(i=0;i<num;i++){
+		size=get_block(i,&pointer);
+		if (size==0) continue;
+		if (begin<(pointer<<2) || ((pointer+size)<<2)<=begin) continue;
+		return begin+len<=((pointer+size)<<2);
+	}
+	// Not allocated
+	return 0;
+}
+
+void* lib_calloc_memory(int size, int* classdata){
+	// Allocate an object (see NEW function)
+	int i,ei;
+	int* ret;
+	// Disable interrupt
+	ei=IEC0&_IEC0_CS1IE_MASK;
+	IEC0CLR=_IEC0_CS1IE_MASK;
+	// Find object pool of the class, or register new one
+	i=search_obj_pool(classdata);
+	if (i<0 && g_pool_num<OBJ_POOL_NUM) {
+		i=g_pool_num++;
+		g_pool_class[i]=classdata;
+		g_pool_head[i]=0;
+		g_pool_live[i]=0;
+		g_pool_free[i]=0;
+	}
+	if (0<=i && g_pool_head[i]) {
+		// Reuse the object in pool
+		ret=g_pool_head[i];
+		g_pool_head[i]=(int*)ret[0];
+		g_pool_free[i]--;
+		g_pool_hits++;
+	} else {
+		// Allocate memory
+		ret=(int*)alloc_perm_memory(size);
+		g_pool_misses++;
+	}
+	if (0<=i) g_pool_live[i]++;
+	// Enable interrupt
+	IEC0SET=ei;
+	// First word of object is pointer to class structure.
+	// Fill zero in the other area.
+	ret[0]=(int)classdata;
+	for(i=1;i<size;i++){
+		ret[i]=0;
+	}
+	return (void*)ret;
 }
 
 void lib_delete(int* object){
+	int i,j,size,ei;
+	int* classdata;
+	// Disable interrupt
+	ei=IEC0&_IEC0_CS1IE_MASK;
+	IEC0CLR=_IEC0_CS1IE_MASK;
+	// Check if object of a class using object pool
+	j=search_perm_block(((int)object-(int)g_heap_mem)>>2);
+	if (0<=j) {
+		size=g_perm_table[j]&0xffff;
+		classdata=(int*)object[0];
+		i=search_obj_pool(classdata);
+		if (0<=i && size==object_size(classdata)) {
+			// Keep the object in pool
+			object[0]=(int)g_pool_head[i];
+			g_pool_head[i]=object;
+			g_pool_free[i]++;
+			g_pool_live[i]--;
+			// Enable interrupt
+			IEC0SET=ei;
+			return;
+		} else if (classdata==(int*)lib_map) {
+			// Map (see map.c)
+			IEC0SET=ei;
+			map_delete(object);
+			return;
+		} else if (in_obj_pool(object,size)) {
+			// Already deleted
+			IEC0SET=ei;
+			return;
+		}
+	}
+	// Enable interrupt
+	IEC0SET=ei;
 	// Remove region that fit to object
 	free_non_temp_str((char*)object);
 }
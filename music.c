@@ -352,8 +352,8 @@ void musicint(){
 			} else if (0x80<OC4RS) {
 				OC4RS--;
 			}
-			if (OC3RS==0x80 && OC4RS==0x80) {
-				// Stop interrupt
+			if (OC3RS==0x80 && OC4RS==0x80 && !file_async_remaining()) {
+				// Stop interrupt unless reading file in background (see FGETASYNC)
 				IEC0bits.CS0IE=0;
 			}
 			break;
@@ -886,6 +886,7 @@ void play_wave(char* filename, int start){
 		wavtable=(char*)alloc_memory(524*2/4,ALLOC_WAVE_BLOCK);
 	}
 	// Open file
+	file_async_wait();
 	if (g_fhandle) FSfclose(g_fhandle);
 	g_fhandle=openWave(filename);
 	// Support defined start position here to skip file pointer here.
@@ -0,0 +1,222 @@
+/*
+   This file is provided under the LGPL license ver 2.1.
+   Written by Katsumi.
+   http://hp.vector.co.jp/authors/VA016157/
+   kmorimatsu@users.sourceforge.jp
+*/
+
+/*
+	This file is shared by Megalopa and Zoea
+*/
+
+#include "compiler.h"
+
+/*
+	RAM disk
+	The file with name beginning with "R:" (e.g. "R:TEMP.DAT") is stored in heap
+	area instead of SD card. When current directory is set to "R:" by SETDIR,
+	relative names are also for RAM disk. RAM disk is a flat directory, and its
+	size is only limited by free heap area. All files are lost by CLEAR and at the
+	end of program (see ramdisk_init()). Buffered file access in library.c uses
+	following functions instead of SD library for the files on RAM disk.
+
+	RAM file structure (permanent block):
+		rfile[0]: pointer to next RAM file, or 0
+		rfile[1]: pointer to data (permanent block), or 0
+		rfile[2]: size of file (bytes)
+		rfile[3]: size of data block (bytes)
+		rfile[4]: number of handles opening this file
+		rfile[5]: pointer to file name (permanent block)
+
+	Handle structure of opened RAM file (permanent block):
+		rh[0]: pointer to RAM file
+		rh[1]: current position
+		rh[2]: 1 if writable
+*/
+
+#define RAMDISK_FILE_SIZE   6
+#define RAMDISK_HANDLE_SIZE 3
+// Minimum size of data block (bytes; multiple of 4)
+#define RAMDISK_BLOCK_SIZE  256
+
+// List of RAM files
+static int* s_ramdisk;
+// Current directory is RAM disk
+static char s_ramdisk_cwd;
+
+void ramdisk_init(void){
+	// Forget all files, as heap area is cleared.
+	s_ramdisk=0;
+	s_ramdisk_cwd=0;
+}
+
+const char* ramdisk_file(const char* name){
+	// Returns the file name on RAM disk, or 0 if the file is on SD card.
+	if ((name[0]=='R' || name[0]=='r') && name[1]==':') {
+		name+=2;
+	} else if (!s_ramdisk_cwd || name[0]=='\\' || name[0]=='/') {
+		return 0;
+	}
+	while (name[0]=='\\' || name[0]=='/') name++;
+	return name;
+}
+
+int ramdisk_chdir(const char* path){
+	// SETDIR. Returns 1 if current directory becomes RAM disk.
+	// Otherwise, directory of SD card will be changed by caller.
+	s_ramdisk_cwd=0;
+	path=ramdisk_file(path);
+	if (!path || path[0]) return 0;
+	s_ramdisk_cwd=1;
+	return 1;
+}
+
+int ramdisk_cwd(void){
+	return s_ramdisk_cwd;
+}
+
+static int ramdisk_name_equal(const char* name1, const char* name2){
+	// Case-insensitive like FAT file system
+	char c1,c2;
+	do {
+		c1=*name1++;
+		c2=*name2++;
+		if ('a'<=c1 && c1<='z') c1-=0x20;
+		if ('a'<=c2 && c2<='z') c2-=0x20;
+		if (c1!=c2) return 0;
+	} while(c1);
+	return 1;
+}
+
+static int* ramdisk_search(const char* name, int** prev){
+	// Returns RAM file, or 0 if not found.
+	// Previous file in the list is set to *prev.
+	int* rfile;
+	*prev=0;
+	for(rfile=s_ramdisk;rfile;rfile=(int*)rfile[0]){
+		if (ramdisk_name_equal((char*)rfile[5],name)) return rfile;
+		*prev=rfile;
+	}
+	return 0;
+}
+
+static int* ramdisk_create(const char* name){
+	int i;
+	int* rfile;
+	char* str;
+	for(i=0;name[i];i++);
+	str=(char*)alloc_perm_memory((i+4)>>2);
+	for(i=0;str[i]=name[i];i++);
+	rfile=alloc_perm_memory(RAMDISK_FILE_SIZE);
+	rfile[0]=(int)s_ramdisk;
+	rfile[1]=0;
+	rfile[2]=0;
+	rfile[3]=0;
+	rfile[4]=0;
+	rfile[5]=(int)str;
+	s_ramdisk=rfile;
+	return rfile;
+}
+
+int* ramdisk_fopen(const char* name, const char* mode){
+	// Like FSfopen(). Returns handle of opened file, or 0 if failed.
+	int* rfile;
+	int* rh;
+	int* prev;
+	name=ramdisk_file(name);
+	if (!name || !name[0]) return 0;
+	rfile=ramdisk_search(name,&prev);
+	switch(mode[0]){
+		case 'r': case 'R':
+			if (!rfile) return 0;
+			break;
+		case 'w': case 'W':
+			if (!rfile) rfile=ramdisk_create(name);
+			rfile[2]=0;
+			break;
+		case 'a': case 'A':
+			if (!rfile) rfile=ramdisk_create(name);
+			break;
+		default:
+			return 0;
+	}
+	rh=alloc_perm_memory(RAMDISK_HANDLE_SIZE);
+	rh[0]=(int)rfile;
+	rh[1]=(mode[0]=='a' || mode[0]=='A') ? rfile[2]:0;
+	rh[2]=(mode[0]=='r' || mode[0]=='R') && mode[1]!='+' ? 0:1;
+	rfile[4]++;
+	return rh;
+}
+
+void ramdisk_fclose(int* rh){
+	((int*)rh[0])[4]--;
+	free_perm_str((char*)rh);
+}
+
+int ramdisk_fread(char* dest, int len, int* rh){
+	// Like FSfread(). Returns number of bytes read.
+	int* rfile=(int*)rh[0];
+	if (rfile[2]-rh[1]<len) len=rfile[2]-rh[1];
+	if (len<=0) return 0;
+	mem_copy(dest,(char*)rfile[1]+rh[1],len);
+	rh[1]+=len;
+	return len;
+}
+
+int ramdisk_fwrite(char* src, int len, int* rh){
+	// Like FSfwrite(). Data block is extended if needed.
+	int size;
+	char* data;
+	int* rfile=(int*)rh[0];
+	if (!rh[2] || len<=0) return 0;
+	if (rfile[3]<rh[1]+len) {
+		// Double the size of block, at least
+		size=rfile[3]*2;
+		if (size<rh[1]+len) size=rh[1]+len;
+		if (size<RAMDISK_BLOCK_SIZE) size=RAMDISK_BLOCK_SIZE;
+		size=(size+3)&0xFFFFFFFC;
+		data=(char*)alloc_perm_memory(size>>2);
+		if (rfile[1]) {
+			mem_copy(data,(char*)rfile[1],rfile[2]);
+			free_perm_str((char*)rfile[1]);
+		}
+		rfile[1]=(int)data;
+		rfile[3]=size;
+	}
+	mem_copy((char*)rfile[1]+rh[1],src,len);
+	rh[1]+=len;
+	if (rfile[2]<rh[1]) rfile[2]=rh[1];
+	return len;
+}
+
+int ramdisk_fseek(int* rh, int pos){
+	// Like FSfseek() with SEEK_SET. Returns 0 if successful.
+	if (pos<0 || ((int*)rh[0])[2]<pos) return -1;
+	rh[1]=pos;
+	return 0;
+}
+
+int ramdisk_ftell(int* rh){
+	return rh[1];
+}
+
+int ramdisk_fsize(int* rh){
+	return ((int*)rh[0])[2];
+}
+
+int ramdisk_remove(const char* name){
+	// Like FSremove(). Returns 0 if successful, or -1 if failed.
+	int* rfile;
+	int* prev;
+	name=ramdisk_file(name);
+	if (!name) return -1;
+	rfile=ramdisk_search(name,&prev);
+	// Opened file cannot be removed.
+	if (!rfile || rfile[4]) return -1;
+	if (prev) prev[0]=rfile[0];
+	else s_ramdisk=(int*)rfile[0];
+	if (rfile[1]) free_perm_str((char*)rfile[1]);
+	free_perm_str((char*)rfile[5]);
+	free_perm_str((char*)rfile);
+	return 0;
+}
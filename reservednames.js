@@ -148,6 +148,9 @@ var namearray=[
 	'INPUT',
 	'INT',
 	'KEYS',
+	'KVGET',
+	'KVOPEN',
+	'KVPUT',
 	'LABEL',
 	'LEN',
 	'LET',
@@ -155,6 +158,14 @@ var namearray=[
 	'LOG',
 	'LOG10',
 	'LOOP',
+	'MAPDEL',
+	'MAPGET',
+	'MAPHAS',
+	'MAPNEW',
+	'MAPSET',
+	'MEMCMP',
+	'MEMCPY',
+	'MEMSET',
 	'MODF',
 	'MUSIC',
 	'NEXT',
@@ -184,6 +195,7 @@ var namearray=[
 	'SGN',
 	'SIN',
 	'SINH',
+	'SORT',
 	'SOUND',
 	'SQRT',
 	'SYSTEM',
@@ -196,6 +208,7 @@ var namearray=[
 	'USEVAR',
 	'VAL',
 	'VAR',
+	'VDIM',
 	'WAIT',
 	'WEND',
 	'WHILE',
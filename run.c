@@ -75,6 +75,7 @@ int runbasic(char *appname,int test){
 	clearscreen();
 	setcursor(0,0,7);
 	g_long_name_var_num=0;
+	g_dead_code_size=0;
 	cmpdata_init();
 
 	// Initialize music system
@@ -91,6 +92,11 @@ int runbasic(char *appname,int test){
 
 	// All done
 	printstr("done\n");
+	if (g_dead_code_size) {
+		// Report the size of removed codes
+		printdec(g_dead_code_size);
+		printstr(" bytes of dead code removed\n");
+	}
 	if(test) return 0; //RpĈ݂̏ꍇ
 	wait60thsec(15);
 
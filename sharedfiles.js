@@ -23,8 +23,10 @@ var filearray=[
 	'globalvars.c',
 	'library.c',
 	'linker.c',
+	'map.c',
 	'memory.c',
 	'operator.c',
+	'ramdisk.c',
 	'run.c',
 	'string.c',
 	'statement.c',
@@ -266,39 +266,148 @@ char* poke_statement_sub(int bits){
 	return 0;
 }
 
+int dim_const_size(int pos){
+	// Returns the value + 1 if the code from pos is constant (see get_simple_value()).
+	// Otherwise, returns 0.
+	if (g_object[pos]==0x00000000) pos++; // nop
+	if (pos+1==g_objpos && (g_object[pos]>>16)==0x3402) {
+		// ori v0,zero,xxxx
+		return (g_object[pos]&0xFFFF)+1;
+	} else if (pos+2==g_objpos && (g_object[pos]>>16)==0x3C02 && (g_object[pos+1]>>16)==0x3442) {
+		// lui v0,xxxx; ori v0,v0,xxxx
+		return (g_object[pos]<<16|g_object[pos+1]&0xFFFF)+1;
+	}
+	return 0;
+}
+
+char* dim_record(int i, int* data){
+	// See CMPDATA_DIM structure in value.c
+	// data[0]: number of dimensions (n), or 0 if the size is not constant,
+	//          and number of bits of a value in bits 8-15
+	// data[1]-data[n]: sizes + 1
+	int* record;
+	int j;
+	record=search_dim_record(i);
+	if (!record) return cmpdata_insert(CMPDATA_DIM,i,data,(data[0]&0xFF)+1);
+	// The codes for accessing array may be already compiled.
+	if ((record[1]^data[0])&(DIM_VDIM_RECORD|0xFF00)) return ERR_DIM_TYPE;
+	if (!(record[1]&0xFF)) return 0;
+	if ((record[1]&0xFFFF)!=data[0]) return ERR_FLATDIM_SIZE;
+	for(j=1;j<=(data[0]&0xFF);j++){
+		if (record[j+1]!=data[j]) return ERR_FLATDIM_SIZE;
+	}
+	return 0;
+}
+
 char* dim_statement(){
 	char* err;
 	char b1;
 	int i;
 	int spos;
 	int stack;
+	int opos;
+	int bits,flags;
+	int data[9];
 	while(1){
 		stack=0;
+		data[0]=0;
+		bits=32;
+		flags=0;
 		next_position();
 		i=get_var_number();
 		if (i<0) return ERR_SYNTAX;
-		if (g_source[g_srcpos]=='#') g_srcpos++;
+		if (g_source[g_srcpos]=='#') {
+			g_srcpos++;
+		} else if (g_source[g_srcpos]=='%') {
+			// 8 or 16 bit values
+			g_srcpos++;
+			if (nextCodeIs("8")) {
+				bits=8;
+				flags=DIM_8BIT;
+			} else if (nextCodeIs("16")) {
+				bits=16;
+				flags=DIM_16BIT;
+			} else {
+				return ERR_SYNTAX;
+			}
+		}
 		next_position();
 		if (g_source[g_srcpos]!='(') return ERR_SYNTAX;
 		check_obj_space(1);
 		spos=g_objpos++;           // addiu       sp,sp,xxxx
 		do {
 			g_srcpos++;
+			opos=g_objpos;
 			err=get_value();
 			if (err) return err;
 			stack+=4;
+			// Constant sizes for flat array (see dim_record())
+			if (stack==4 || data[0]) {
+				data[0]=0;
+				if (stack<=32) {
+					data[stack/4]=dim_const_size(opos);
+					if (data[stack/4]) data[0]=stack/4;
+				}
+			}
 			check_obj_space(1);
 			g_object[g_objpos++]=0xAFA20000|stack; // sw          v0,8(sp)
 		} while (g_source[g_srcpos]==',');
 		if (g_source[g_srcpos]!=')') return ERR_SYNTAX;
 		g_srcpos++;
+		// Initialize by DATA/CDATA region (DIM A(x)=DATA LABEL)
+		next_position();
+		if (g_source[g_srcpos]=='=') {
+			// This form is not valid in class file.
+			if (g_compiling_class) return ERR_INVALID_CLASS;
+			g_srcpos++;
+			next_position();
+			if (nextCodeIs("DATA")) {
+				flags|=DIM_DATA;
+			} else if (nextCodeIs("CDATA")) {
+				flags|=DIM_CDATA;
+			} else {
+				return ERR_SYNTAX;
+			}
+			err=get_label();
+			if (err) return err;
+			if (g_label) {
+				// Label/number is constant.
+				// Linker will change following codes later.
+				// Note that 0x0814xxxx and 0x0815xxxx are specific codes for these.
+				check_obj_space(2);
+				g_object[g_objpos++]=0x08140000|((g_label>>16)&0x0000FFFF); // lui   v0,xxxx
+				g_object[g_objpos++]=0x08150000|(g_label&0x0000FFFF);       // ori v0,v0,xxxx
+			} else {
+				// Label/number will be dynamically set when executing code.
+				err=get_value();
+				if (err) return err;
+				call_lib_code(LIB_LABEL);
+			}
+			// Pointer to label follows the sizes in stack (see lib_dim())
+			check_obj_space(1);
+			g_object[g_objpos++]=0xAFA20000|(stack+4); // sw          v0,xx(sp)
+		}
+		if (g_option_flatdim && 4<stack) {
+			// Flat array (see OPTION FLATDIM)
+			flags|=DIM_FLAT;
+		} else {
+			data[0]=0;
+		}
+		data[0]|=bits<<8;
+		err=dim_record(i,data);
+		if (err) return err;
+		if (4<stack) {
+			err=dim_layout(i);
+			if (err) return err;
+		}
 		check_obj_space(3);
 		g_object[g_objpos++]=0x24040000|(i);       // addiu       a0,zero,xx
 		g_object[g_objpos++]=0x24050000|(stack/4); // addiu       a1,zero,xxxx
 		g_object[g_objpos++]=0x03A01025;           // or          v0,sp,zero
-		call_lib_code(LIB_DIM);
+		call_lib_code(LIB_DIM | flags);
 		// Stack -/+
 		check_obj_space(1);
+		if (flags & (DIM_DATA|DIM_CDATA)) stack+=4;
 		g_object[g_objpos++]=0x27BD0000|stack;     // addiu       sp,sp,xxxx
 		stack=(0-stack)&0x0000FFFF;
 		g_object[spos]=0x27BD0000|stack;           // addiu       sp,sp,xxxx
@@ -329,6 +438,71 @@ char* label_statement(){
 	return 0;
 }
 
+char* vdim_statement(){
+	// VDIM A(N),"FILE"[,H]
+	char* err;
+	int i,flags,data;
+	flags=0;
+	data=32<<8;
+	next_position();
+	i=get_var_number();
+	if (i<0) return ERR_SYNTAX;
+	if (g_source[g_srcpos]=='#') {
+		g_srcpos++;
+	} else if (g_source[g_srcpos]=='%') {
+		// 8 or 16 bit values
+		g_srcpos++;
+		if (nextCodeIs("8")) {
+			data=8<<8;
+			flags=VDIM_8BIT;
+		} else if (nextCodeIs("16")) {
+			data=16<<8;
+			flags=VDIM_16BIT;
+		} else {
+			return ERR_SYNTAX;
+		}
+	}
+	next_position();
+	if (g_source[g_srcpos]!='(') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BDFFF8;          // addiu       sp,sp,-8
+	// Get size
+	err=get_value();
+	if (err) return err;
+	if (g_source[g_srcpos]!=')') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(1);
+	g_object[g_objpos++]=0xAFA20004;          // sw          v0,4(sp)
+	// Get file name
+	next_position();
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	err=get_string();
+	if (err) return err;
+	check_obj_space(1);
+	g_object[g_objpos++]=0xAFA20008;          // sw          v0,8(sp)
+	// Get file handle (optional)
+	next_position();
+	if (g_source[g_srcpos]==',') {
+		g_srcpos++;
+		err=get_value();
+		if (err) return err;
+	} else {
+		check_obj_space(1);
+		g_object[g_objpos++]=0x24020000;      // addiu       v0,zero,0
+	}
+	data|=DIM_VDIM_RECORD;
+	err=dim_record(i,&data);
+	if (err) return err;
+	check_obj_space(1);
+	g_object[g_objpos++]=0x24040000|i;        // addiu       a0,zero,xx
+	call_lib_code(LIB_VDIM | VDIM_NEW | flags);
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BD0008;          // addiu       sp,sp,8
+	return 0;
+}
+
 char* restore_statement(){
 	char* err;
 	// This statement is not valid in class file.
@@ -600,13 +774,80 @@ char* end_statement(void){
 	return 0;
 }
 
+char* let_vdim_sub(int i, int isfloat){
+	// A(X)=Y for array defined by VDIM (see lib_vdim())
+	char* err;
+	g_srcpos++;
+	err=get_value();
+	if (err) return err;
+	if (g_source[g_srcpos]!=')') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(2);
+	g_object[g_objpos++]=0x27BDFFFC;              // addiu sp,sp,-4
+	g_object[g_objpos++]=0xAFA20004;              // sw    v0,4(sp)
+	next_position();
+	if (g_source[g_srcpos]!='=') return ERR_SYNTAX;
+	g_srcpos++;
+	if (isfloat) err=get_float();
+	else err=get_value();
+	if (err) return err;
+	check_obj_space(1);
+	g_object[g_objpos++]=0x24040000|i;            // addiu a0,zero,xx
+	call_lib_code(LIB_VDIM | VDIM_SET);
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BD0004;              // addiu sp,sp,4
+	return 0;
+}
+
+char* let_flat_dim_sub(int i){
+	// See get_flat_dim_value()
+	char* err;
+	int dim;
+	dim=1;
+	do {
+		g_srcpos++;
+		dim++;
+		check_obj_space(1);
+		g_object[g_objpos++]=0xAFA20004;              // sw    v0,4(sp)
+		err=get_value();
+		if (err) return err;
+		check_obj_space(1);
+		g_object[g_objpos++]=0x8FA30004;              // lw    v1,4(sp)
+		err=flat_dim_mul(i,dim);
+		if (err) return err;
+		check_obj_space(1);
+		g_object[g_objpos++]=0x00621021;              // addu  v0,v1,v0
+	} while (g_source[g_srcpos]==',');
+	check_obj_space(5);
+	g_object[g_objpos++]=dim_sll_code(get_dim_bits(i)); // sll v0,v0,xx
+	g_object[g_objpos++]=0x8FC30000|(i*4);            // lw    v1,xx(s8)
+	g_object[g_objpos++]=0x00621821;                  // addu  v1,v1,v0
+	g_object[g_objpos++]=0x24630000|((dim-1)*4);      // addiu v1,v1,xx
+	g_object[g_objpos++]=0xAFA30004;                  // sw    v1,4(sp)
+	if (g_source[g_srcpos]!=')') return ERR_SYNTAX;
+	g_srcpos++;
+	return 0;
+}
+
 char* let_dim_sub(int i){
+	// Note that only the last dimension may be 8 or 16 bit values (see get_dim_value()).
 	char* err;
+	int bits;
 	g_srcpos++;
 	err=get_value();
 	if (err) return err;
+	if (g_source[g_srcpos]==',') {
+		err=dim_layout(i);
+		if (err) return err;
+		if (g_option_flatdim) return let_flat_dim_sub(i);
+	}
+	bits=get_dim_bits(i);
 	check_obj_space(4);
-	g_object[g_objpos++]=0x00021080;              // sll v0,v0,0x2
+	if (g_source[g_srcpos]==',') {
+		g_object[g_objpos++]=0x00021080;          // sll v0,v0,0x2
+	} else {
+		g_object[g_objpos++]=dim_sll_code(bits);  // sll v0,v0,xx
+	}
 	g_object[g_objpos++]=0x8FC30000|(i*4);        // lw    v1,xx(s8)
 	g_object[g_objpos++]=0x00621821;              // addu  v1,v1,v0
 	g_object[g_objpos++]=0xAFA30004;              // sw    v1,4(sp)
@@ -614,8 +855,12 @@ char* let_dim_sub(int i){
 		g_srcpos++;
 		err=get_value();
 		if (err) return err;
-		check_obj_space(4);
-		g_object[g_objpos++]=0x00021080;          // sll v0,v0,0x2
+		check_obj_space(5);
+		if (g_source[g_srcpos]==',') {
+			g_object[g_objpos++]=0x00021080;      // sll v0,v0,0x2
+		} else {
+			g_object[g_objpos++]=dim_sll_code(bits); // sll v0,v0,xx
+		}
 		g_object[g_objpos++]=0x8FA30004;          // lw    v1,4(sp)
 		g_object[g_objpos++]=0x8C630000;          // lw    v1,0(v1)
 		g_object[g_objpos++]=0x00621821;          // addu  v1,v1,v0
@@ -638,9 +883,12 @@ char* let_statement(){
 	if (b2=='#' && b3=='(') {
 		// Float dimension
 		g_srcpos++;
+		if (get_dim_bits(i)!=32) return ERR_DIM_TYPE;
+		if (is_vdim(i)) return let_vdim_sub(i,1);
 		check_obj_space(1);
 		g_object[g_objpos++]=0x27BDFFFC;              // addiu sp,sp,-4
-		let_dim_sub(i);
+		err=let_dim_sub(i);
+		if (err) return err;
 		next_position();
 		if (g_source[g_srcpos]!='=') return ERR_SYNTAX;
 		g_srcpos++;
@@ -659,9 +907,7 @@ char* let_statement(){
 		g_srcpos++;
 		err=get_float();
 		if (err) return err;
-		check_obj_space(1);
-		g_object[g_objpos++]=0xAFC20000|(i*4);        // sw v0,xxx(s8)
-		return 0;
+		return field_or_var_code(i,0xAFC20000);       // sw v0,xxx(s8)
 	} else 	if (b2=='$') {
 		// String
 		g_srcpos++;
@@ -676,9 +922,11 @@ char* let_statement(){
 		return 0;
 	} else if (b2=='(') {
 		// Dimension
+		if (is_vdim(i)) return let_vdim_sub(i,0);
 		check_obj_space(1);
 		g_object[g_objpos++]=0x27BDFFFC;              // addiu sp,sp,-4
-		let_dim_sub(i);
+		err=let_dim_sub(i);
+		if (err) return err;
 		if (g_source[g_srcpos]=='.') {
 			// This is an object. Determine the filed of this object.
 			// 4(sp) contains the address of dimension value
@@ -697,13 +945,25 @@ char* let_statement(){
 		check_obj_space(3);
 		g_object[g_objpos++]=0x8FA30004;              // lw    v1,4(sp)
 		g_object[g_objpos++]=0x27BD0004;              // addiu sp,sp,4
-		g_object[g_objpos++]=0xAC620000;              // sw    v0,0(v1)
+		switch(get_dim_bits(i)){
+			case 32:
+				g_object[g_objpos++]=0xAC620000;      // sw    v0,0(v1)
+				break;
+			case 16:
+				g_object[g_objpos++]=0xA4620000;      // sh    v0,0(v1)
+				break;
+			case 8:
+			default:
+				g_object[g_objpos++]=0xA0620000;      // sb    v0,0(v1)
+				break;
+		}
 		return 0;
 	} else if (b2=='.') {
 		// Field of object
 		g_srcpos++;
-		check_obj_space(1);
-		g_object[g_objpos++]=0x8FC20000|(i*4);        // lw    v0,xx(s8)
+		err=field_or_var_code(i,0x8FC20000);          // lw    v0,xx(s8)
+		if (err) return err;
+		g_obj_class=var_class_structure(i);
 		return let_object_field();
 	} else {
 		// Integer A-Z
@@ -712,8 +972,7 @@ char* let_statement(){
 		g_srcpos++;
 		err=get_value();
 		if (err) return err;
-		check_obj_space(1);
-		g_object[g_objpos++]=0xAFC20000|(i*4);        // sw v0,xxx(s8)
+		return field_or_var_code(i,0xAFC20000);       // sw v0,xxx(s8)
 	}
 	return 0;
 }
@@ -1445,11 +1704,122 @@ int FindNext (SearchRec * rec);
 
 */
 
+static int array_param_follows(void){
+	// Check if "A()", "A#()", or "A$()" follows
+	int i;
+	next_position();
+	i=g_srcpos;
+	while('A'<=g_source[i] && g_source[i]<='Z' || '0'<=g_source[i] && g_source[i]<='9' || g_source[i]=='_') i++;
+	if (i==g_srcpos) return 0;
+	if (g_source[i]=='#' || g_source[i]=='$') i++;
+	return g_source[i]=='(' && g_source[i+1]==')';
+}
+
+static char* file_array_statement(int func){
+	// FGET A(),START,COUNT and FPUT A(),START,COUNT
+	char* err;
+	int flags;
+	// Get array
+	err=get_array_param(&flags);
+	if (err) return err;
+	if ((flags & SORT_TYPE_MASK)==SORT_STR) return ERR_SYNTAX;
+	if (flags & SORT_8BIT) func|=FILE_ARRAY;
+	else if (flags & SORT_16BIT) func|=FILE_ARRAY|FILE_ARRAY16;
+	else func|=FILE_ARRAY|FILE_ARRAY32;
+	next_position();
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(2);
+	g_object[g_objpos++]=0x27BDFFF8; // addiu       sp,sp,-8
+	g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
+	// Get start
+	err=get_value();
+	if (err) return err;
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(1);
+	g_object[g_objpos++]=0xAFA20008; // sw          v0,8(sp)
+	// Get count
+	err=get_value();
+	if (err) return err;
+	call_lib_code(LIB_FILE | func);
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BD0008; // addiu       sp,sp,8
+	return 0;
+}
+
 char* fget_statement(){
+	if (array_param_follows()) return file_array_statement(FUNC_FGET);
 	return param2_statement(LIB_FILE | FUNC_FGET);
 }
 
+char* fgetasync_statement(){
+	// FGETASYNC ADDR,LEN
+	return param2_statement(LIB_FILE | FUNC_FGETASYNC);
+}
+
+char* kvopen_statement(){
+	// KVOPEN F$
+	char* err;
+	err=get_string();
+	if (err) return err;
+	call_lib_code(LIB_KVSTORE | KV_OPEN);
+	return 0;
+}
+
+char* kvput_statement(){
+	// KVPUT K$,V
+	char* err;
+	err=get_string();
+	if (err) return err;
+	next_position();
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(2);
+	g_object[g_objpos++]=0x27BDFFFC; // addiu       sp,sp,-4
+	g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
+	err=get_value();
+	if (err) return err;
+	call_lib_code(LIB_KVSTORE | KV_PUT);
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BD0004; // addiu       sp,sp,4
+	return 0;
+}
+
+char* logstart_statement(){
+	// LOGSTART F$,RATE,CHANNELS
+	char* err;
+	err=get_string();
+	if (err) return err;
+	next_position();
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(2);
+	g_object[g_objpos++]=0x27BDFFF8; // addiu       sp,sp,-8
+	g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
+	err=get_value();
+	if (err) return err;
+	next_position();
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(1);
+	g_object[g_objpos++]=0xAFA20008; // sw          v0,8(sp)
+	err=get_value();
+	if (err) return err;
+	call_lib_code(LIB_LOGGER | LOG_START);
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BD0008; // addiu       sp,sp,8
+	return 0;
+}
+
+char* logstop_statement(){
+	// LOGSTOP
+	call_lib_code(LIB_LOGGER | LOG_STOP);
+	return 0;
+}
+
 char* fput_statement(){
+	if (array_param_follows()) return file_array_statement(FUNC_FPUT);
 	return param2_statement(LIB_FILE | FUNC_FPUT);
 }
 
@@ -1469,6 +1839,142 @@ char* fputc_statement(){
 	return 0;
 }
 
+char* get_array_param(int* flags){
+	// Get "A()", "A#()", or "A$()" and set the pointer to array in $v0.
+	// Type and size of value are set to flags (see lib_sort()).
+	int i,type;
+	next_position();
+	i=get_var_number();
+	if (i<0) return ERR_SYNTAX;
+	switch(g_source[g_srcpos]){
+		case '#':
+			g_srcpos++;
+			type=SORT_FLOAT;
+			break;
+		case '$':
+			g_srcpos++;
+			type=SORT_STR;
+			break;
+		default:
+			type=SORT_INT;
+			break;
+	}
+	if (g_source[g_srcpos]!='(' || g_source[g_srcpos+1]!=')') return ERR_SYNTAX;
+	g_srcpos+=2;
+	// VDIM array cannot be accessed directly.
+	if (is_vdim(i)) return ERR_DIM_TYPE;
+	switch(get_dim_bits(i)){
+		case 8:
+			if (type!=SORT_INT) return ERR_DIM_TYPE;
+			type|=SORT_8BIT;
+			break;
+		case 16:
+			if (type!=SORT_INT) return ERR_DIM_TYPE;
+			type|=SORT_16BIT;
+			break;
+		default:
+			break;
+	}
+	*flags=type;
+	return field_or_var_code(i,0x8FC20000); // lw v0,xx(s8)
+}
+
+char* sort_statement(){
+	// SORT A(),N[,I()][,DESC]
+	char* err;
+	int flags,iflags;
+	// Get array
+	err=get_array_param(&flags);
+	if (err) return err;
+	next_position();
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(3);
+	g_object[g_objpos++]=0x27BDFFF8; // addiu       sp,sp,-8
+	g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
+	g_object[g_objpos++]=0xAFA00008; // sw          zero,8(sp)
+	// Get number of values
+	err=get_value();
+	if (err) return err;
+	check_obj_space(2);
+	g_object[g_objpos++]=0x27BDFFFC; // addiu       sp,sp,-4
+	g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
+	next_position();
+	if (g_source[g_srcpos]==',') {
+		g_srcpos++;
+		if (!nextCodeIs("DESC")) {
+			// Get index array
+			err=get_array_param(&iflags);
+			if (err) return err;
+			if (iflags & SORT_TYPE_MASK) return ERR_DIM_TYPE;
+			if (iflags & SORT_8BIT) flags|=SORT_INDEX8;
+			if (iflags & SORT_16BIT) flags|=SORT_INDEX16;
+			check_obj_space(1);
+			g_object[g_objpos++]=0xAFA2000C; // sw          v0,12(sp)
+			next_position();
+			if (g_source[g_srcpos]==',') {
+				g_srcpos++;
+				if (!nextCodeIs("DESC")) return ERR_SYNTAX;
+				flags|=SORT_DESC;
+			}
+		} else {
+			flags|=SORT_DESC;
+		}
+	}
+	check_obj_space(2);
+	g_object[g_objpos++]=0x8FA20004; // lw          v0,4(sp)
+	g_object[g_objpos++]=0x27BD0004; // addiu       sp,sp,4
+	call_lib_code(LIB_SORT | flags);
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BD0008; // addiu       sp,sp,8
+	return 0;
+}
+
+char* get_mem_operand(void){
+	// Address (including array) or string. The pointer will be in $v0.
+	char* err;
+	err=get_stringFloatOrValue();
+	if (err) return err;
+	if (g_lastvar==VAR_FLOAT) return ERR_SYNTAX;
+	return 0;
+}
+
+char* mem_statement_main(int func){
+	// MEMCPY X,Y,N / MEMSET X,Y,N / MEMCMP(X,Y,N)
+	char* err;
+	// Get 1st parameter
+	err=get_mem_operand();
+	if (err) return err;
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(2);
+	g_object[g_objpos++]=0x27BDFFF8; // addiu       sp,sp,-8
+	g_object[g_objpos++]=0xAFA20004; // sw          v0,4(sp)
+	// Get 2nd parameter
+	if (func==MEM_SET) err=get_value();
+	else err=get_mem_operand();
+	if (err) return err;
+	if (g_source[g_srcpos]!=',') return ERR_SYNTAX;
+	g_srcpos++;
+	check_obj_space(1);
+	g_object[g_objpos++]=0xAFA20008; // sw          v0,8(sp)
+	// Get number of bytes
+	err=get_value();
+	if (err) return err;
+	call_lib_code(LIB_MEMORY | func);
+	check_obj_space(1);
+	g_object[g_objpos++]=0x27BD0008; // addiu       sp,sp,8
+	return 0;
+}
+
+char* memcpy_statement(){
+	return mem_statement_main(MEM_COPY);
+}
+
+char* memset_statement(){
+	return mem_statement_main(MEM_SET);
+}
+
 char* fremove_statement(){
 	char* err;
 	err=get_string();
@@ -1479,14 +1985,30 @@ char* fremove_statement(){
 
 char* usevar_statement(){
 	char* err;
-	int i;
+	int i,j;
+	int* record;
 	do {
 		next_position();
 		i=check_var_name();
 		if (i<65536) return ERR_SYNTAX;
-		err=register_var_name(i);
+		if (g_source[g_srcpos]=='#' || g_source[g_srcpos]=='$') {
+			g_srcpos++;
+			err=register_var_name(i);
+		} else if (nextCodeIs("AS ")) {
+			// Object variable with class (USEVAR xxx AS yyy)
+			next_position();
+			j=check_var_name();
+			if (j<65536) return ERR_SYNTAX;
+			cmpdata_reset();
+			while(record=cmpdata_find(CMPDATA_CLASS)){
+				if (record[1]==j) break;
+			}
+			if (!record) return ERR_NO_CLASS;
+			err=register_var_class(i,j);
+		} else {
+			err=register_var_name(i);
+		}
 		if (err) return err;
-		if (g_source[g_srcpos]=='#' || g_source[g_srcpos]=='$') g_srcpos++;
 		next_position();
 		if (g_source[g_srcpos]==',') {
 			g_srcpos++;
@@ -1571,6 +2093,8 @@ char* option_statement(){
 			g_option_nolinenum=1;
 		} else if (nextCodeIs("FASTFIELD")) {
 			g_option_fastfield=1;
+		} else if (nextCodeIs("FLATDIM")) {
+			g_option_flatdim=1;
 		} else if (nextCodeIs("CLASSCODE")) {
 			if (g_compiling_class) {
 				// Do nothing. Do not try to rewind the object,
@@ -1691,6 +2215,7 @@ static const void* statement_list[]={
 	"CDATA ",cdata_statement,
 	"LABEL ",label_statement,
 	"DIM ",dim_statement,
+	"VDIM ",vdim_statement,
 	"CLEAR",clear_statement,
 	"PRINT",print_statement,
 	"IF ",if_statement,
@@ -1724,6 +2249,11 @@ static const void* statement_list[]={
 	"VAR ",var_statement,
 	"DO",do_statement,
 	"LOOP",loop_statement,
+	"MAPSET",mapset_statement,
+	"SORT ",sort_statement,
+	"MEMCPY ",memcpy_statement,
+	"MEMSET ",memset_statement,
+	"MAPDEL",mapdel_statement,
 	"WHILE ",while_statement,
 	"WEND",wend_statement,
 	"BREAK",break_statement,
@@ -1735,6 +2265,11 @@ static const void* statement_list[]={
 	"FCLOSE",fclose_statement,
 	"FPRINT ",fprint_statement,
 	"FGET ",fget_statement,
+	"FGETASYNC ",fgetasync_statement,
+	"KVOPEN ",kvopen_statement,
+	"KVPUT ",kvput_statement,
+	"LOGSTART ",logstart_statement,
+	"LOGSTOP",logstop_statement,
 	"FPUT ",fput_statement,
 	"FPUTC ",fputc_statement,
 	"FSEEK ",fseek_statement,
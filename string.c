@@ -125,8 +125,9 @@ char* simple_string(void){
 		}
 		if (g_source[g_srcpos]=='.') {
 			// This is an object field or method to return string
-			check_obj_space(1);
-			g_object[g_objpos++]=0x8FC20000|(i*4); // lw v0,xx(s8)
+			err=field_or_var_code(i,0x8FC20000); // lw v0,xx(s8)
+			if (err) return err;
+			g_obj_class=var_class_structure(i);
 			g_srcpos++;
 			return pre_string_obj_field();
 		} else if (g_source[g_srcpos]=='(') {
@@ -138,7 +139,11 @@ char* simple_string(void){
 			g_srcpos++;
 			return pre_string_obj_field();
 		}
-		if (g_source[g_srcpos]!='$') return ERR_SYNTAX;
+		if (g_source[g_srcpos]!='$') {
+			// Not a string variable (see count_field_reference())
+			count_field_reference(i,-1);
+			return ERR_SYNTAX;
+		}
 		g_srcpos++;
 		// String variable
 		next_position();
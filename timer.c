@@ -34,6 +34,7 @@ static const void* interrupt_list[]={
 	"MUSIC",    (void*)INTERRUPT_MUSIC,
 	"WAVE",     (void*)INTERRUPT_WAVE,
 	"CORETIMER",(void*)INTERRUPT_CORETIMER,
+	"FILE",     (void*)INTERRUPT_FILE,
 	ADDITIONAL_INTERRUPT_FUNCTIONS
 };
 #define NUM_INTERRUPT_TYPES ((sizeof(interrupt_list)/sizeof(interrupt_list[0]))/2)
@@ -99,6 +100,11 @@ void stop_timer(){
 	#pragma interrupt T1Handler IPL2SOFT vector 4
 #endif
 void T1Handler(void){
+	// Timer1 is used for sampling by LOGSTART
+	if (logger_sample()) {
+		IFS0bits.T1IF=0;
+		return;
+	}
 	g_timer++;
 	// Clear Timer1 interrupt flag
 	IFS0bits.T1IF=0;
@@ -106,33 +112,31 @@ void T1Handler(void){
 	raise_interrupt_flag(INTERRUPT_TIMER);
 }
 
-void lib_usetimer(int usec){
-	int temppr1;
+void start_timer1(int count){
+	// Timer1 interrupt occurs every count clocks.
+	// This is used by USETIMER and LOGSTART.
 	// Stop timer, first
 	T1CON=0x0000;
 	IEC0bits.T1IE=0;
 	TMR1=0;
 	PR1=0xffff;
 	// PR1 setting
-	// ((CPU_CLOCK_HZ/10000)*usec)< 2147483648, 
-	// therefore, the calculation can be done as 32 bit signed integer
-	temppr1=((CPU_CLOCK_HZ/10000)*usec)/100;
-	if (temppr1<=65536) {
+	if (count<=65536) {
 		// no prescaler
 		T1CON=0x0000;
-		PR1=temppr1-1;
-	} else if ((temppr1>>3)<=65536) {
+		PR1=count-1;
+	} else if ((count>>3)<=65536) {
 		// 1/8 prescaler
 		T1CON=0x0010;
-		PR1=(temppr1>>3)-1;
-	} else if ((temppr1>>6)<=65536) {
+		PR1=(count>>3)-1;
+	} else if ((count>>6)<=65536) {
 		// 1/64 prescaler
 		T1CON=0x0020;
-		PR1=(temppr1>>6)-1;
-	} else if ((temppr1>>8)<=65536) {
+		PR1=(count>>6)-1;
+	} else if ((count>>8)<=65536) {
 		// 1/256 prescaler
 		T1CON=0x0030;
-		PR1=(temppr1>>8)-1;
+		PR1=(count>>8)-1;
 	} else {
 		err_invalid_param();
 	}
@@ -141,10 +145,18 @@ void lib_usetimer(int usec){
 	IPC1bits.T1IS=0;
 	IEC0bits.T1IE=1;
 	// Start timer
-	g_timer=0;
 	T1CONbits.ON=1;
 }
 
+void lib_usetimer(int usec){
+	// ((CPU_CLOCK_HZ/10000)*usec)< 2147483648, 
+	// therefore, the calculation can be done as 32 bit signed integer
+	// Timer1 is used by LOGSTART while logging.
+	if (logger_active()) err_invalid_param();
+	g_timer=0;
+	start_timer1(((CPU_CLOCK_HZ/10000)*usec)/100);
+}
+
 char* usetimer_statement(){
 	char* err;
 	err=get_value();
@@ -218,7 +230,7 @@ char* coretimer_statement(){
 
 void BasicInt(int addr,void* memory){
 	// Store $s5-$s8 and $ra
-	// Note that $s0-$s4 are not saved here as these are not yet used in MachiKania BASIC
+	// Note that $s0-$s4 are saved in CS1Handler()
 	asm volatile("#":::"s5");
 	asm volatile("#":::"s6");
 	asm volatile("#":::"s7");
@@ -226,7 +238,7 @@ void BasicInt(int addr,void* memory){
 	asm volatile("#":::"ra");
 	// Note that $s5-$s7 and $fp values must be set again here.
 	// Set s5 for initial_s5_stack
-	asm volatile("la $s5,%0"::"i"(&g_initial_s5_stack[2]));
+	asm volatile("la $s5,%0"::"i"(&g_initial_s5_stack[3]));
 	// Set s7 for easy calling call_library()
 	asm volatile("la $s7,%0"::"i"(&call_library));
 	// Set fp and execute BASIC code at $a0
@@ -245,6 +257,8 @@ void CS1Handler(void){
 	asm volatile("#":::"ra");
 	// Do until all interrupt flags are down
 	do {
+		// Write the buffer of LOGSTART if full
+		logger_flush();
 		for(i=0;i<NUM_INTERRUPT_TYPES;i++){
 			if (g_interrupt_flags & (1<<i)) {
 				g_interrupt_flags &= (1<<i)^0xffff;
@@ -254,7 +268,7 @@ void CS1Handler(void){
 		// Clear CS1IF again here
 		// Note that if g_interrupt_flags is raised, do loop continues.
 		IFS0bits.CS1IF=0;
-	} while (g_interrupt_flags);
+	} while (g_interrupt_flags || logger_pending());
 }
 
 void lib_interrupt_main(int itype, int address){
@@ -339,6 +353,8 @@ char* interrupt_statement(){
 	2) Check buttons for KEYS interrupt
 	3) Check PS/2 for INKEY interrupt
 	4) DRAWCOUNT interrupt
+	5) Read file in background for FGETASYNC
+		FILE interrupt is taken by library.c
 */
 
 const int* g_keystatus=(int*)&ps2keystatus[0];
@@ -374,4 +390,6 @@ void CS0Handler(void){
 	if (g_int_vector[INTERRUPT_INKEY]) {
 		if (keycodeExists()) raise_interrupt_flag(INTERRUPT_INKEY);
 	}
+	// Read file in background
+	file_async_interrupt();
 }
@@ -49,16 +49,204 @@ char* pre_integer_obj_field(void){
 char* get_value();
 char* get_value_sub(int pr);
 
+/*
+	CMPDATA_DIM structure
+		type:      CMPDATA_DIM (8)
+		len:       n+2
+		data16:    variable number
+		record[1]: bits 0-7:  number of dimensions (n), or 0 if the size is not constant
+		           bits 8-15: number of bits of a value (8, 16, or 32)
+		           bit 16:    set if array is defined by VDIM (DIM_VDIM_RECORD)
+		           bit 17:    set if layout of multi-dimensional array is determined
+		           bit 18:    set if the layout is flat (see dim_layout())
+		record[2]: size of 1st dimension + 1
+		...
+		record[n+1]: size of nth dimension + 1
+*/
+
+/*
+	Flat array (OPTION FLATDIM)
+	Multi-dimensional array is allocated as a single block in lib_dim(). The first n-1 
+	words contain the sizes (+1) of 2nd-nth dimensions, and values follow.
+	A(X,Y,Z) is the ((X*d2+Y)*d3+Z)th value, where dn is the size of nth dimension + 1.
+*/
+
+int* search_dim_record(int i){
+	int* record;
+	cmpdata_reset();
+	while(record=cmpdata_find(CMPDATA_DIM)){
+		if ((record[0]&0xFFFF)==i) return record;
+	}
+	return 0;
+}
+
+int get_dim_bits(int i){
+	// Returns the number of bits of a value in array (8, 16, or 32).
+	// When array is not defined by DIM yet, it is treated as the array of 32 bit values.
+	int* record;
+	int data;
+	record=search_dim_record(i);
+	if (record) return (record[1]>>8)&0xFF;
+	data=32<<8;
+	cmpdata_insert(CMPDATA_DIM,i,&data,1);
+	return 32;
+}
+
+int is_vdim(int i){
+	// Returns 1 if array is defined by VDIM statement.
+	int* record;
+	record=search_dim_record(i);
+	if (record && (record[1]&DIM_VDIM_RECORD)) return 1;
+	return 0;
+}
+
+char* dim_layout(int i){
+	// Called when multi-dimensional array is defined or accessed.
+	// The A-Z arrays are shared by main and class files, but OPTION FLATDIM is given
+	// for each file. The layout is recorded with the first use, and a file using
+	// the other layout causes an error.
+	int* record;
+	int data;
+	int layout=DIM_LAYOUT_RECORD;
+	if (g_option_flatdim) layout|=DIM_FLAT_RECORD;
+	record=search_dim_record(i);
+	if (!record) {
+		data=(32<<8)|layout;
+		return cmpdata_insert(CMPDATA_DIM,i,&data,1);
+	}
+	if (!(record[1]&DIM_LAYOUT_RECORD)) {
+		record[1]|=layout;
+		return 0;
+	}
+	if ((record[1]^layout)&DIM_FLAT_RECORD) return ERR_FLATDIM_LAYOUT;
+	return 0;
+}
+
+int dim_sll_code(int bits){
+	switch(bits){
+		case 32:
+			return 0x00021080; // sll v0,v0,0x2
+		case 16:
+			return 0x00021040; // sll v0,v0,0x1
+		case 8:
+		default:
+			return 0x00021000; // sll v0,v0,0x0
+	}
+}
+
+int dim_load_code(int bits){
+	switch(bits){
+		case 32:
+			return 0x8C620000; // lw v0,0(v1)
+		case 16:
+			return 0x94620000; // lhu v0,0(v1)
+		case 8:
+		default:
+			return 0x90620000; // lbu v0,0(v1)
+	}
+}
+
+char* flat_dim_mul(int i, int dim){
+	// $v1=$v1*(size of dimension + 1)
+	int* record;
+	int d,s;
+	record=search_dim_record(i);
+	if (record && dim<=(record[1]&0xFF)) {
+		// Size is constant
+		d=record[dim+1];
+		if (0<d && !(d&(d-1))) {
+			for(s=0;(1<<s)<d;s++);
+			if (s) {
+				check_obj_space(1);
+				g_object[g_objpos++]=0x00031800|(s<<6);  // sll v1,v1,xx
+			}
+			return 0;
+		} else if (-0x8000<=d && d<=0x7FFF) {
+			check_obj_space(1);
+			g_object[g_objpos++]=0x24080000|(d&0xFFFF); // addiu t0,zero,xxxx
+		} else {
+			check_obj_space(2);
+			g_object[g_objpos++]=0x3C080000|((d>>16)&0xFFFF); // lui t0,xxxx
+			g_object[g_objpos++]=0x35080000|(d&0xFFFF);       // ori t0,t0,xxxx
+		}
+	} else {
+		// Get size from the header of array
+		check_obj_space(2);
+		g_object[g_objpos++]=0x8FC80000|(i*4);         // lw t0,xx(s8)
+		g_object[g_objpos++]=0x8D080000|((dim-2)*4);   // lw t0,xx(t0)
+	}
+	check_obj_space(1);
+	g_object[g_objpos++]=0x70681802;                   // mul v1,v1,t0
+	return 0;
+}
+
+char* get_flat_dim_value(int i){
+	char* err;
+	int dim,bits;
+	g_sdepth+=4;
+	if (g_maxsdepth<g_sdepth) g_maxsdepth=g_sdepth;
+	dim=1;
+	do {
+		g_srcpos++;
+		dim++;
+		check_obj_space(1);
+		g_object[g_objpos++]=0xAFA20000|g_sdepth;      // sw v0,xx(sp)
+		err=get_value_sub(priority(OP_VOID));
+		if (err) return err;
+		check_obj_space(1);
+		g_object[g_objpos++]=0x8FA30000|g_sdepth;      // lw v1,xx(sp)
+		err=flat_dim_mul(i,dim);
+		if (err) return err;
+		check_obj_space(1);
+		g_object[g_objpos++]=0x00621021;               // addu v0,v1,v0
+	} while (g_source[g_srcpos]==',');
+	g_sdepth-=4;
+	bits=get_dim_bits(i);
+	check_obj_space(4);
+	g_object[g_objpos++]=dim_sll_code(bits);           // sll v0,v0,xx
+	g_object[g_objpos++]=0x8FC30000|(i*4);             // lw v1,xx(s8)
+	g_object[g_objpos++]=0x00621821;                   // addu v1,v1,v0
+	g_object[g_objpos++]=dim_load_code(bits)|((dim-1)*4); // lw v0,xx(v1)
+	if (g_source[g_srcpos]!=')') return ERR_SYNTAX;
+	g_srcpos++;
+	return 0;
+}
+
 char* get_dim_value(int i){
+	// Note that only the last dimension may be 8 or 16 bit values.
+	// Other dimensions are the pointers to next dimension (see lib_dim()).
 	char* err;
+	int bits;
 	err=get_value_sub(priority(OP_VOID));
 	if (err) return err;
-	check_obj_space(4);
-	g_object[g_objpos++]=0x00021080;              // sll v0,v0,0x2
-	g_object[g_objpos++]=0x8FC30000|(i*4);        // lw v1,xx(s8)
-	g_object[g_objpos++]=0x00621821;              // addu v1,v1,v0
-	g_object[g_objpos++]=0x8C620000;              // lw v0,0(v1)
 	next_position();
+	if (is_vdim(i)) {
+		// VDIM array is one-dimensional and accessed by library (see lib_vdim()).
+		if (g_source[g_srcpos]!=')') return ERR_SYNTAX;
+		g_srcpos++;
+		check_obj_space(1);
+		g_object[g_objpos++]=0x24040000|i; // addiu a0,zero,xx
+		call_lib_code(LIB_VDIM | VDIM_GET);
+		return 0;
+	}
+	if (g_source[g_srcpos]==',') {
+		err=dim_layout(i);
+		if (err) return err;
+		if (g_option_flatdim) return get_flat_dim_value(i);
+	}
+	bits=get_dim_bits(i);
+	check_obj_space(4);
+	if (g_source[g_srcpos]==',') {
+		g_object[g_objpos++]=0x00021080;          // sll v0,v0,0x2
+		g_object[g_objpos++]=0x8FC30000|(i*4);    // lw v1,xx(s8)
+		g_object[g_objpos++]=0x00621821;          // addu v1,v1,v0
+		g_object[g_objpos++]=0x8C620000;          // lw v0,0(v1)
+	} else {
+		g_object[g_objpos++]=dim_sll_code(bits);  // sll v0,v0,xx
+		g_object[g_objpos++]=0x8FC30000|(i*4);    // lw v1,xx(s8)
+		g_object[g_objpos++]=0x00621821;          // addu v1,v1,v0
+		g_object[g_objpos++]=dim_load_code(bits); // lw v0,0(v1)
+	}
 	if (g_source[g_srcpos]==','){
 		// 2D, 3D or more
 		// Use a stack
@@ -71,10 +259,17 @@ char* get_dim_value(int i){
 			err=get_value_sub(priority(OP_VOID));
 			if (err) return err;
 			check_obj_space(5);
-			g_object[g_objpos++]=0x00021080;               // sll v0,v0,0x2
-			g_object[g_objpos++]=0x8FA30000|g_sdepth;      // lw v1,xx(sp)
-			g_object[g_objpos++]=0x00621821;               // addu v1,v1,v0
-			g_object[g_objpos++]=0x8C620000;               // lw v0,0(v1)
+			if (g_source[g_srcpos]==',') {
+				g_object[g_objpos++]=0x00021080;           // sll v0,v0,0x2
+				g_object[g_objpos++]=0x8FA30000|g_sdepth;  // lw v1,xx(sp)
+				g_object[g_objpos++]=0x00621821;           // addu v1,v1,v0
+				g_object[g_objpos++]=0x8C620000;           // lw v0,0(v1)
+			} else {
+				g_object[g_objpos++]=dim_sll_code(bits);   // sll v0,v0,xx
+				g_object[g_objpos++]=0x8FA30000|g_sdepth;  // lw v1,xx(sp)
+				g_object[g_objpos++]=0x00621821;           // addu v1,v1,v0
+				g_object[g_objpos++]=dim_load_code(bits);  // lw v0,0(v1)
+			}
 		} while (g_source[g_srcpos]==',');
 		g_sdepth-=4;
 	}
@@ -197,13 +392,15 @@ char* get_simple_value(void){
 				err=get_dim_value(i);
 				if (err) return err;
 			} else {
-				// Simple value
-				check_obj_space(1);
-				g_object[g_objpos++]=0x8FC20000|(i*4); // lw v0,xx(s8)
+				// Simple value (or field in class file)
+				err=field_or_var_code(i,0x8FC20000); // lw v0,xx(s8)
+				if (err) return err;
 			}
 			// Check if this is an object
 			if (g_source[g_srcpos]=='.') {
 				// This is an object. See the filed of it.
+				// The class is known if not a dimension (see USEVAR xxx AS yyy).
+				if (g_source[g_srcpos-1]!=')') g_obj_class=var_class_structure(i);
 				g_srcpos++;
 				return pre_integer_obj_field();
 			}
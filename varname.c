@@ -80,6 +80,9 @@ static const int reserved_var_names[]={
 	0x0114b178, /*INPUT*/
 	0x00013391, /*INT*/
 	0x0009d063, /*KEYS*/
+	0x0153dfd1, /*KVGET*/
+	0x3101c0dc, /*KVOPEN*/
+	0x01541242, /*KVPUT*/
 	0x016022dc, /*LABEL*/
 	0x00014249, /*LEN*/
 	0x0001424f, /*LET*/
@@ -87,6 +90,14 @@ static const int reserved_var_names[]={
 	0x000143b4, /*LOG*/
 	0x016b0db9, /*LOG10*/
 	0x000aca45, /*LOOP*/
+	0x36edf070, /*MAPDEL*/
+	0x36ee0083, /*MAPGET*/
+	0x36ee0547, /*MAPHAS*/
+	0x36ee25f5, /*MAPNEW*/
+	0x36ee40af, /*MAPSET*/
+	0x375dfe70, /*MEMCMP*/
+	0x375dfee8, /*MEMCPY*/
+	0x375e52dc, /*MEMSET*/
 	0x000b8e81, /*MODF*/
 	0x018c8c85, /*MUSIC*/
 	0x000c21d6, /*NEXT*/
@@ -116,6 +127,7 @@ static const int reserved_var_names[]={
 	0x00016802, /*SGN*/
 	0x0001684c, /*SIN*/
 	0x0010130d, /*SINH*/
+	0x001033c3, /*SORT*/
 	0x02338a69, /*SOUND*/
 	0x00103e75, /*SQRT*/
 	0x526b8f2e, /*SYSTEM*/
@@ -128,6 +140,7 @@ static const int reserved_var_names[]={
 	0x59f9673f, /*USEVAR*/
 	0x0001772d, /*VAL*/
 	0x00017733, /*VAR*/
+	0x00124933, /*VDIM*/
 	0x0012ff0c, /*WAIT*/
 	0x00131519, /*WEND*/
 	0x02a044ad, /*WHILE*/
@@ -234,6 +247,8 @@ int get_var_number(){
 		// If found, returns the value that can be used as the index of $s8
 		i=search_var_name(i);
 		if (i<0) return -1;
+		// Count reference to field in class file (see resolve_field_codes())
+		count_field_reference(i+ALLOC_LNV_BLOCK,1);
 	}
 	// This var name is defined by USEVAR statement.
 	return i+ALLOC_LNV_BLOCK;
@@ -271,3 +286,41 @@ char* register_var_name(int nameint){
 	g_temp=nameint;
 	return cmpdata_insert(CMPDATA_USEVAR,g_long_name_var_num++,&g_temp,1);
 }
+
+/*
+	char* register_var_class(int nameint, int class);
+	This function is called when compiler detects "USEVAR xxx AS yyy" statement.
+	It registers the long var name with the class name of object.
+*/
+
+char* register_var_class(int nameint, int class){
+	int data[2];
+	// Check if registered before. If did, cause error.
+	if (search_var_name(nameint)!=-1) return ERR_INVALID_VAR_NAME;
+	// Number of long var name is restricted
+	if (ALLOC_LNV_NUM<=g_long_name_var_num) return ERR_INVALID_VAR_NAME;
+	// Register var name and class name as a compile data
+	data[0]=nameint;
+	data[1]=class;
+	return cmpdata_insert(CMPDATA_USEVAR,g_long_name_var_num++,&data[0],2);
+}
+
+/*
+	int search_var_class(int var_num);
+	This function returns the class name of object variable defined by
+	"USEVAR xxx AS yyy" statement. If not defined so, returns 0.
+*/
+
+int search_var_class(int var_num){
+	int* cmpdata;
+	if (var_num<ALLOC_LNV_BLOCK) return 0;
+	var_num-=ALLOC_LNV_BLOCK;
+	cmpdata_reset();
+	while(cmpdata=cmpdata_find(CMPDATA_USEVAR)){
+		if ((cmpdata[0]&0x0000ffff)!=var_num) continue;
+		// Length is 3 when class name is registered
+		if ((cmpdata[0]&0x00ff0000)==0x00030000) return cmpdata[2];
+		return 0;
+	}
+	return 0;
+}